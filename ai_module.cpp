@@ -28,6 +28,7 @@
 
 //-- Constant values
 #define TINDEX_DEFAULT 1024
+#define BANK_UNKNOWN 0xFF
 #define DATA_DESCRIPTION_SIZE 32
 
 //-- define AI Module Interrupt values
@@ -53,6 +54,7 @@ struct data_description_struct
 
 /* ---- internal commands function prototypes declaration ---- */
 void reset();
+void select_bank(uint8_t bank);
 void control_command(uint8_t command);
 void function_read_sram_data(uint8_t *array, int32_t length);
 void read_data_description(struct data_description_struct *description);
@@ -61,15 +63,23 @@ void clear_event(uint8_t event_type);
 void set_parameter_Event(uint8_t event_type);
 void set_parameter_Tindex(uint32_t T_index);
 void parse_od(uint8_t  *data, struct od_data_struct *od);
-// check if the event happens during handling JPEG
-void recheck_event_before_clear_jpeg(uint8_t e, struct od_data_struct *od_data);
-void handle_event(uint8_t e, uint8_t recheck_which_event, struct od_data_struct *od_data);
+void save_frame_markers(struct data_description_struct *description);
+uint8_t select_jpeg_frames(uint32_t *t_index, enum AI_MODULE_JPEG_FRAME *frame);
+void handle_event(uint8_t e, struct od_data_struct *od_data);
+// handle every event set in the interrupt status, return true if OD results were stored
+bool dispatch_events(uint8_t event_into_status, struct od_data_struct *od_data);
 
 //-- Global variables
 uint8_t pin_cs, pin_rst;
+uint8_t current_bank = BANK_UNKNOWN;    // register bank last selected, bank 0 is selected between API calls
 struct data_description_struct data_description;
 uint8_t data_buffer[AI_MODULE_BUFFER_SIZE] = { 0 };
 FunPtr_SaveJPEG save_jpeg_func = NULL;  // function pointer to store user_jpeg_save_func
+uint8_t jpeg_frames = JPEG_FRAME_DEFAULT;
+struct ai_module_frame_markers_struct frame_markers;
+bool frame_markers_valid = false;
+bool frame_markers_fresh = false;   // the markers come from the OD event dispatched with the current events
+enum AI_MODULE_JPEG_FRAME jpeg_frame = JPEG_FRAME_DEFAULT;  // frame of the JPEG being saved
 
 bool ai_module_init(uint8_t ai_module_pin_cs, uint8_t ai_module_pin_rst)
 {
@@ -87,13 +97,14 @@ bool ai_module_init(uint8_t ai_module_pin_cs, uint8_t ai_module_pin_rst)
     // initialize CS & RST pin states
     interface_digital_write(pin_rst, HIGH);
     interface_digital_write(pin_cs, HIGH);
-    usleep(1000);
+    interface_delay_us(1000);
     interface_digital_write(pin_cs, LOW);
-    usleep(1000);
+    interface_delay_us(1000);
     interface_digital_write(pin_cs, HIGH);
-    usleep(1000);
+    interface_delay_us(1000);
 
-    interface_spi_write(pin_cs, BANK_SEL, 0x00);			// Switch to bank 0
+    current_bank = BANK_UNKNOWN;
+    select_bank(0);			// Switch to bank 0
     partid_value = interface_spi_read(pin_cs, R_PART_ID_LSB) + (interface_spi_read(pin_cs, R_PART_ID_MSB) << 8);
 
     if (partid_value != (PART_ID_LSB_CONST_VAL + (PART_ID_MSB_CONST_VAL << 8)))
@@ -106,7 +117,7 @@ bool ai_module_init(uint8_t ai_module_pin_cs, uint8_t ai_module_pin_rst)
     // reset the module before wake up
     reset();
 
-    interface_spi_write(pin_cs, BANK_SEL, 0x00);
+    select_bank(0);
     interface_spi_write(pin_cs, CPU_VALID_CONTROL, 0x01);	// CPU on
     interface_spi_write(pin_cs, R_CPU_RESET_ENL, 0x01);
 
@@ -119,7 +130,7 @@ bool ai_module_init(uint8_t ai_module_pin_cs, uint8_t ai_module_pin_rst)
         power_on_ready = (temp_value & 0x01);
         if (power_on_ready == 0x01)
             break;
-        usleep(10000);
+        interface_delay_us(10000);
         counter++;
     }
 
@@ -136,19 +147,29 @@ bool ai_module_init(uint8_t ai_module_pin_cs, uint8_t ai_module_pin_rst)
             break;
         }
 
-        usleep(10000);
+        interface_delay_us(10000);
         counter++;
     }
-    usleep(100000);
+    interface_delay_us(100000);
     return true;
 }
 
 void ai_module_set_od_threshold(const uint8_t *th_values)
 {
-    interface_spi_write(pin_cs, BANK_SEL, 14);  // switch to bank 14
+    select_bank(14);  // switch to bank 14
     for(uint8_t i = 0; i < MAX_OD_SUPPORT_TYPES; i++)
         interface_spi_write(pin_cs, 74 + i, th_values[i]);
-    interface_spi_write(pin_cs, BANK_SEL, 0);   // switch to bank 0
+    select_bank(0);   // switch to bank 0
+}
+
+void ai_module_set_od_threshold_type(uint8_t type_index, uint8_t th_value)
+{
+    if(type_index >= MAX_OD_SUPPORT_TYPES)
+        return;
+
+    select_bank(14);  // switch to bank 14
+    interface_spi_write(pin_cs, 74 + type_index, th_value);
+    select_bank(0);   // switch to bank 0
 }
 
 void reset()
@@ -157,17 +178,42 @@ void reset()
     ai_module_switch_mode(IDLE_MODE);
 
     interface_digital_write(pin_rst, LOW);
-    usleep(10000);
+    interface_delay_us(10000);
     interface_digital_write(pin_rst, HIGH);
-    usleep(50000);
+    interface_delay_us(50000);
+    current_bank = BANK_UNKNOWN;    // the register bank is reset with the module
+}
+
+void select_bank(uint8_t bank)
+{   // skip the bank selection if the bank is already selected
+    if(bank == current_bank)
+        return;
+    interface_spi_write(pin_cs, BANK_SEL, bank);
+    current_bank = bank;
 }
 
 void ai_module_set_jpeg_quality(enum JPEG_QUALITY jpeg_quality)
 {
-    interface_spi_write(pin_cs, BANK_SEL, 0); // switch to bank 0
+    select_bank(0); // switch to bank 0
     interface_spi_write(pin_cs, R_JPEG_QUALITY, (int8_t)jpeg_quality);
 }
 
+void ai_module_set_jpeg_frames(uint8_t frames)
+{
+    jpeg_frames = frames & (JPEG_FRAME_MOTION | JPEG_FRAME_OD | JPEG_FRAME_CURRENT);
+}
+
+bool ai_module_get_frame_markers(struct ai_module_frame_markers_struct *markers)
+{
+    memcpy(markers, &frame_markers, sizeof(struct ai_module_frame_markers_struct));
+    return frame_markers_valid;
+}
+
+enum AI_MODULE_JPEG_FRAME ai_module_get_jpeg_frame()
+{
+    return jpeg_frame;
+}
+
 void ai_module_register_save_jpeg_func(FunPtr_SaveJPEG user_save_jpeg_func)
 {
     save_jpeg_func = user_save_jpeg_func;
@@ -175,21 +221,21 @@ void ai_module_register_save_jpeg_func(FunPtr_SaveJPEG user_save_jpeg_func)
 
 void control_command(uint8_t command)
 {
-    interface_spi_write(pin_cs, BANK_SEL, 0); // switch to bank 0
+    select_bank(0); // switch to bank 0
     interface_spi_write(pin_cs, R_OP_HOST_REQ, command);			// Write REQ_DATA_INIT (0x03) to R_OP_HOST_REQ (0x21) register
     while (interface_spi_read(pin_cs, R_OP_HOST_REQ) != 0);			// Wait for PAG7681LS handled the request
 }
 
 void ai_module_switch_mode(enum AI_MODULE_MODE mode)
 {
-    interface_spi_write(pin_cs, BANK_SEL, 0); // switch to bank 0
+    select_bank(0); // switch to bank 0
     // remeber to switch to IDLE_MODE before changing to any other operation mode
     interface_spi_write(pin_cs, R_OP_MODE_HOST, IDLE_MODE);
-    usleep(100000);
+    interface_delay_us(100000);
     if(mode == IDLE_MODE)
         return;
     interface_spi_write(pin_cs, R_OP_MODE_HOST, (uint8_t)mode);
-    usleep(300000);
+    interface_delay_us(300000);
 }
 
 void function_read_sram_data(uint8_t * array, int32_t length)
@@ -285,29 +331,55 @@ void parse_od(uint8_t *data, struct od_data_struct* od)
     }
 }
 
-void recheck_event_before_clear_jpeg(uint8_t e, struct od_data_struct *od_data)
+void save_frame_markers(struct data_description_struct *description)
+{
+    frame_markers.motion_frame = description->t1_motion_frame;
+    frame_markers.start_frame = description->t2_start_frame;
+    frame_markers.end_frame = description->t3_end_frame;
+    frame_markers.current_frame = description->t4_current_frame;
+    frame_markers.od_frame = description->t5_od_frame;
+    frame_markers_valid = true;
+    frame_markers_fresh = true;
+}
+
+uint8_t select_jpeg_frames(uint32_t *t_index, enum AI_MODULE_JPEG_FRAME *frame)
 {
-    uint8_t event_into_status = interface_spi_read(pin_cs, R_INTO_STATUS);
+    uint8_t count = 0;
 
-    if ((event_into_status & e) == e)
+    // chronological order, skip the frames already selected with the same index
+    const enum AI_MODULE_JPEG_FRAME order[3] = { JPEG_FRAME_MOTION, JPEG_FRAME_OD, JPEG_FRAME_CURRENT };
+    const uint32_t index[3] = { frame_markers.motion_frame, frame_markers.od_frame, frame_markers.current_frame };
+    bool is_default = jpeg_frames == JPEG_FRAME_DEFAULT || !frame_markers_fresh;
+    for(uint8_t i = 0; i < 3 && !is_default; i++)
     {
-        switch (e)
+        if((jpeg_frames & order[i]) == 0)
+            continue;
+        // the markers of an earlier event may point to frames AI module no longer keeps
+        if(index[i] - frame_markers.start_frame > frame_markers.end_frame - frame_markers.start_frame)
         {
-            case OD_EVENT:
-                set_parameter_Event(OD_EVENT);
-                read_data_description(&data_description);
-                memset(data_buffer, 0, AI_MODULE_BUFFER_SIZE);
-                read_data(&data_description, data_buffer);
-                parse_od(data_buffer, od_data);
-
-                break;
-            default:
-                break;
+            is_default = true;
+            break;
         }
+        bool is_selected = false;
+        for(uint8_t k = 0; k < count; k++)
+            is_selected = is_selected || t_index[k] == index[i];
+        if(is_selected)
+            continue;
+        t_index[count] = index[i];
+        frame[count] = order[i];
+        count++;
     }
+
+    if(is_default)
+    {
+        t_index[0] = TINDEX_DEFAULT;
+        frame[0] = JPEG_FRAME_DEFAULT;
+        return 1;
+    }
+    return count;
 }
 
-void handle_event(uint8_t e, uint8_t recheck_which_event, struct od_data_struct *od_data)
+void handle_event(uint8_t e, struct od_data_struct *od_data)
 {
     switch (e)
     {
@@ -317,6 +389,7 @@ void handle_event(uint8_t e, uint8_t recheck_which_event, struct od_data_struct
         case OD_EVENT:
             set_parameter_Event(OD_EVENT);
             read_data_description(&data_description);
+            save_frame_markers(&data_description);
             memset(data_buffer, 0, AI_MODULE_BUFFER_SIZE);
             read_data(&data_description, data_buffer);
             clear_event(OD_EVENT);
@@ -324,21 +397,31 @@ void handle_event(uint8_t e, uint8_t recheck_which_event, struct od_data_struct
                 parse_od(data_buffer, od_data);
             break;
         case JPEG_EVENT:
-            set_parameter_Tindex(TINDEX_DEFAULT);
-            set_parameter_Event(JPEG_EVENT);
-            read_data_description(&data_description);
-            memset(data_buffer, 0, AI_MODULE_BUFFER_SIZE);
-            read_data(&data_description, data_buffer);
+        {
+            uint32_t t_index[3];
+            enum AI_MODULE_JPEG_FRAME frame[3];
+            uint8_t frame_num = select_jpeg_frames(t_index, frame);
+
+            // retrieve only the selected frames
+            for(uint8_t i = 0; i < frame_num; i++)
+            {
+                set_parameter_Tindex(t_index[i]);
+                set_parameter_Event(JPEG_EVENT);
+                read_data_description(&data_description);
+                memset(data_buffer, 0, AI_MODULE_BUFFER_SIZE);
+                read_data(&data_description, data_buffer);
 
-            // call the user JPEG saving function to save the frame makes OD triggered before clear the JPEG event
-            if(save_jpeg_func != NULL)
-                save_jpeg_func(data_buffer, data_description.total_length, od_data);
-            
-            if(recheck_which_event != 0)
-                recheck_event_before_clear_jpeg(recheck_which_event, od_data);
+                // call the user JPEG saving function to save the frame makes OD triggered before clear the JPEG event
+                jpeg_frame = frame[i];
+                if(save_jpeg_func != NULL)
+                    save_jpeg_func(data_buffer, data_description.total_length, od_data);
+            }
+            jpeg_frame = JPEG_FRAME_DEFAULT;
 
+            // an OD event raised while retrieving the JPEG stays pending and is handled by the next status read
             clear_event(JPEG_EVENT);
             break;
+        }
         default:
             break;
     }
@@ -350,30 +433,65 @@ enum AI_MODULE_MODE ai_module_get_mode()
     return mode;
 }
 
+bool dispatch_events(uint8_t event_into_status, struct od_data_struct *od_data)
+{
+    bool is_obj_detected = false;
+
+    // the selected JPEG frames are only retrieved with the markers of an OD event dispatched along with the JPEG event
+    frame_markers_fresh = false;
+    if(event_into_status & READY_EVENT)
+        handle_event(READY_EVENT, NULL);
+    // OD results are retrieved before the JPEG so that they are passed to the save JPEG function
+    if(event_into_status & OD_EVENT)
+    {
+        handle_event(OD_EVENT, od_data);
+        is_obj_detected = true;
+    }
+    if(event_into_status & JPEG_EVENT)
+        handle_event(JPEG_EVENT, is_obj_detected ? od_data : NULL);
+
+    // acknowledge the events unknown to this library so that they do not stay pending
+    uint8_t unknown_events = event_into_status & ~(READY_EVENT | OD_EVENT | JPEG_EVENT);
+    for(uint8_t bit = 0x01; unknown_events != 0; bit <<= 1)
+    {
+        if(unknown_events & bit)
+        {
+            clear_event(bit);
+            unknown_events &= ~bit;
+        }
+    }
+    return is_obj_detected;
+}
+
 bool ai_module_process_event(struct od_data_struct *od_data)
 {
     uint8_t event_into_status = 0;
 
-    interface_spi_write(pin_cs, BANK_SEL, 0); // switch to bank 0
+    select_bank(0); // switch to bank 0
     event_into_status = interface_spi_read(pin_cs, R_INTO_STATUS);
+    if(event_into_status == 0)
+        return false;
+
+    return dispatch_events(event_into_status, od_data);
+}
+
+uint8_t ai_module_drain_events(struct od_data_struct *od_results, uint8_t max_results, uint32_t budget_us)
+{
+    uint8_t result_num = 0;
+    uint32_t start_us = interface_micros();
 
-    switch (event_into_status)
+    select_bank(0); // switch to bank 0
+    // status reads are bounded so that an event which cannot be cleared does not hold the caller
+    for(uint16_t reads = 0; result_num < max_results && reads < 2 * max_results + 2; reads++)
     {
-        case READY_EVENT:
-            handle_event(READY_EVENT, 0, NULL);
-            break;
-        case OD_EVENT:
-            handle_event(OD_EVENT, 0, od_data);
-            return true;
-        case JPEG_EVENT:
-            handle_event(JPEG_EVENT, 0, NULL);
+        uint8_t event_into_status = interface_spi_read(pin_cs, R_INTO_STATUS);
+        if(event_into_status == 0)
             break;
-        case (JPEG_EVENT | OD_EVENT): // 0x42
-            handle_event(OD_EVENT, 0, od_data);
-            handle_event(JPEG_EVENT, OD_EVENT, od_data);
-            return true;
-        default:
+
+        if(dispatch_events(event_into_status, &od_results[result_num]))
+            result_num++;
+        if(budget_us != 0 && interface_micros() - start_us >= budget_us)
             break;
     }
-    return false;
-}
\ No newline at end of file
+    return result_num;
+}
@@ -2,6 +2,7 @@
     Description: This is the sample code for complete API (OD/S-Motion OD/S_MOTION_JPEG_OD) for InstAI C-series AI Module
     Modified Date: Feb 25, 2023
     Remark: this C/C++ Library only supports single AI module connected to the host
+        the selected register bank is cached, do not write the bank selection register outside of this library
 */
 
 #ifndef AI_MODULE_H
@@ -19,6 +20,11 @@
 //-- Constant values
 #define MAX_OD_SUPPORT_TYPES    21
 #define MAX_OD_SUPPORT_OBJECTS  30
+// frame resolution which OD coordinates (center_x, center_y, width, height) are relative to
+#define AI_MODULE_FRAME_WIDTH   320
+#define AI_MODULE_FRAME_HEIGHT  240
+// object_type value of the first entry in the OD threshold table
+#define OD_OBJECT_TYPE_OFFSET   2
 
 //-- Host platform dependency value
 #define AI_MODULE_BUFFER_SIZE 30 * 1024
@@ -56,7 +62,32 @@ enum JPEG_QUALITY
     JPEG_QUALITY_HIGH_VAL = 0x20
 };
 
+/**
+    @brief: frames of the triggered event which can be retrieved as JPEG
+    @remark: host selects one or several frames (bitwise OR) by calling function ai_module_set_jpeg_frames(),
+        the frame indexes are given by the frame markers of the OD event (see ai_module_get_frame_markers())
+*/
+enum AI_MODULE_JPEG_FRAME
+{
+    JPEG_FRAME_DEFAULT = 0x00,  // frame chosen by AI module
+    JPEG_FRAME_MOTION = 0x01,   // first frame of the motion (motion onset)
+    JPEG_FRAME_OD = 0x02,       // frame in which the objects were detected
+    JPEG_FRAME_CURRENT = 0x04   // latest captured frame
+};
+
 //-- Structures
+/**
+    @brief: frame indexes reported by AI module with the OD event
+    @remark: retrieved by calling function ai_module_get_frame_markers() after an OD event was processed
+*/
+struct ai_module_frame_markers_struct {
+    uint32_t motion_frame;      // t1: first frame of the motion
+    uint32_t start_frame;       // t2: oldest frame kept by AI module
+    uint32_t end_frame;         // t3: newest frame kept by AI module
+    uint32_t current_frame;     // t4: latest captured frame
+    uint32_t od_frame;          // t5: frame in which the objects were detected
+};
+
 /**
     @brief: data structure of each detected object attributes
     @remark: the detected object attributes could be obtained by calling function ai_module_process_event()
@@ -119,6 +150,17 @@ bool ai_module_init(uint8_t ai_module_pin_cs, uint8_t ai_module_pin_rst);
 */
 void ai_module_set_od_threshold(const uint8_t *th_values);
 
+/**
+    @brief: set OD event triggering threshold value of a single type of objects
+    @parameter:
+        type_index: index of the object type in the threshold table (0 ~ 20, i.e. object type 2 ~ 22)
+        th_value:   OD event triggering threshold value
+    @return:
+        (NONE)
+    @remark: writes only the register of the given type, other threshold values are kept
+*/
+void ai_module_set_od_threshold_type(uint8_t type_index, uint8_t th_value);
+
 /**
     @brief: set JPEG quality saved in SRAM of AI module
     @parameter:
@@ -128,6 +170,39 @@ void ai_module_set_od_threshold(const uint8_t *th_values);
     @remark: JPEG quality should be set after AI module initialization
 */
 void ai_module_set_jpeg_quality(enum JPEG_QUALITY jpeg_quality);
+
+/**
+    @brief: select the frames retrieved as JPEG for each JPEG event
+    @parameter:
+        frames: JPEG_FRAME_DEFAULT, or bitwise OR of JPEG_FRAME_MOTION, JPEG_FRAME_OD and JPEG_FRAME_CURRENT
+    @return:
+        (NONE)
+    @remark: each selected frame is retrieved and passed to the save JPEG function in chronological order,
+        frames with the same index are retrieved once, JPEG_FRAME_DEFAULT is used for a JPEG event which did not come with
+        an OD event, or when a selected frame is no longer kept by AI module (outside start_frame ~ end_frame)
+*/
+void ai_module_set_jpeg_frames(uint8_t frames);
+
+/**
+    @brief: get the frame indexes reported with the last OD event
+    @parameter:
+        markers: give the variable with type "ai_module_frame_markers_struct" to store the frame indexes
+    @return:
+        return true if an OD event has been processed and the markers are available
+        otherwise, return false
+*/
+bool ai_module_get_frame_markers(struct ai_module_frame_markers_struct *markers);
+
+/**
+    @brief: get the frame of the JPEG being passed to the save JPEG function
+    @parameter:
+        (NONE)
+    @return:
+        one of the frames defined in enumeration AI_MODULE_JPEG_FRAME
+    @remark: call it from the save JPEG function to tell the selected frames apart
+*/
+enum AI_MODULE_JPEG_FRAME ai_module_get_jpeg_frame();
+
 /**
     @brief: register save JPEG function implemented on your platform
     @parameter:
@@ -160,6 +235,7 @@ enum AI_MODULE_MODE ai_module_get_mode();
 /**
     @brief: process OD event / JPEG event if any event(s) triggered, OD event results would be stored in the given parameter od_data
         captured image would also be saved if AI module is in OD_JPEG_MODE or S_MOTION_OD_JPEG_MODE
+        every event set in the interrupt status is handled with a single status read, unknown events are acknowledged
     @parameter:
         od_data: give the variable with type "od_data_struct" to store the detected OD event information and object attributes
     @return:
@@ -169,4 +245,17 @@ enum AI_MODULE_MODE ai_module_get_mode();
 */
 bool ai_module_process_event(struct od_data_struct *od_data);
 
+/**
+    @brief: process all pending events, OD event results are stored as a batch in the given array
+    @parameter:
+        od_results:     give the array of "od_data_struct" to store the OD results of the events, in the order they were raised
+        max_results:    number of elements of od_results, processing stops once it is full
+        budget_us:      processing stops once this time is elapsed (checked after each event), 0 = no time limit
+    @return:
+        number of OD results stored in od_results
+    @remark: the interrupt status is read again after each handled event until no event is pending,
+        so events raised while retrieving data (e.g. a JPEG) are handled without waiting for the next poll
+*/
+uint8_t ai_module_drain_events(struct od_data_struct *od_results, uint8_t max_results, uint32_t budget_us);
+
 #endif // AI_MODULE_H
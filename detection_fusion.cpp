@@ -0,0 +1,307 @@
+/** InstAI Co. (Public Version)
+    Description: Fusion of the OD results of several AI modules with overlapping views into a single deduplicated detection stream
+    Modified Date: Oct 19, 2026
+*/
+#include "detection_fusion.h"
+
+//-- Constant values
+#define CLOCK_WINDOW_US     10000000    // the frame clock offset is the smallest one observed over the last 1 ~ 2 windows
+#define NO_BOX              (-1)
+
+/* ---- internal function prototypes declaration ---- */
+static uint32_t estimate_capture_time(struct detection_fusion_struct *fusion, uint8_t module,
+    const struct ai_module_frame_markers_struct *markers, uint32_t host_us);
+static void add_boxes(struct detection_fusion_struct *fusion, uint8_t module, const struct od_data_struct *od_result);
+static bool is_overlapped(const struct detection_fusion_box_struct *a, const struct detection_fusion_box_struct *b, uint8_t iou_threshold_percent);
+static void give_fused_result(struct detection_fusion_struct *fusion);
+
+void detection_fusion_default_config(struct detection_fusion_config_struct *config, uint8_t module_num)
+{
+    memset(config, 0, sizeof(struct detection_fusion_config_struct));
+    config->module_num = module_num;
+    for(uint8_t m = 0; m < DETECTION_FUSION_MAX_MODULES; m++)
+    {
+        config->homography[m][0] = 1.0f;
+        config->homography[m][4] = 1.0f;
+        config->homography[m][8] = 1.0f;
+    }
+    config->output_width = AI_MODULE_FRAME_WIDTH;
+    config->output_height = AI_MODULE_FRAME_HEIGHT;
+    config->frame_period_us = 100000;
+    config->align_window_us = 50000;
+    config->max_latency_us = 100000;
+    config->iou_threshold_percent = 50;
+}
+
+bool detection_fusion_init(struct detection_fusion_struct *fusion, const struct detection_fusion_config_struct *config,
+    FunPtr_FusedResult fused_func)
+{
+    uint32_t columns = ((uint32_t)config->output_width + (1 << DETECTION_FUSION_CELL_SHIFT) - 1) >> DETECTION_FUSION_CELL_SHIFT;
+    uint32_t rows = ((uint32_t)config->output_height + (1 << DETECTION_FUSION_CELL_SHIFT) - 1) >> DETECTION_FUSION_CELL_SHIFT;
+    if(config->module_num == 0 || config->module_num > DETECTION_FUSION_MAX_MODULES || columns * rows == 0
+        || columns * rows > DETECTION_FUSION_MAX_CELLS)
+        return false;
+
+    memset(fusion, 0, sizeof(struct detection_fusion_struct));
+    fusion->config = *config;
+    fusion->fused_func = fused_func;
+    return true;
+}
+
+static uint32_t estimate_capture_time(struct detection_fusion_struct *fusion, uint8_t module,
+    const struct ai_module_frame_markers_struct *markers, uint32_t host_us)
+{
+    if(markers == NULL)
+        return host_us;
+
+    // the host time of frame 0 seen through the smallest retrieval delay, kept modulo 2^32 like interface_micros()
+    struct detection_fusion_clock_struct *clock = &fusion->clock[module];
+    uint32_t period = fusion->config.frame_period_us;
+    uint32_t offset = host_us - markers->current_frame * period;
+    if(!clock->is_valid)
+    {
+        clock->is_valid = true;
+        clock->offset_us = clock->window_offset_us = offset;
+        clock->window_start_us = host_us;
+    }
+    else
+    {
+        if((int32_t)(offset - clock->window_offset_us) < 0)
+            clock->window_offset_us = offset;
+        if((int32_t)(offset - clock->offset_us) < 0)
+            clock->offset_us = offset;
+        if(host_us - clock->window_start_us >= CLOCK_WINDOW_US)
+        {   // forget the older window to follow the drift between the module and host clocks
+            clock->offset_us = clock->window_offset_us;
+            clock->window_offset_us = offset;
+            clock->window_start_us = host_us;
+        }
+    }
+
+    uint32_t capture_us = clock->offset_us + markers->od_frame * period;
+    if((int32_t)(capture_us - host_us) > 0)
+        capture_us = host_us;
+    return capture_us;
+}
+
+static void add_boxes(struct detection_fusion_struct *fusion, uint8_t module, const struct od_data_struct *od_result)
+{
+    const float *h = fusion->config.homography[module];
+    uint8_t object_num = od_result->object_num < MAX_OD_SUPPORT_OBJECTS ? od_result->object_num : MAX_OD_SUPPORT_OBJECTS;
+
+    for(uint8_t i = 0; i < object_num && fusion->box_num < DETECTION_FUSION_MAX_BOXES; i++)
+    {
+        const struct od_object_unit_struct *object = &od_result->object[i];
+        float half_width = object->width * 0.5f, half_height = object->height * 0.5f;
+        float corner_x[4] = {object->center_x - half_width, object->center_x + half_width,
+            object->center_x + half_width, object->center_x - half_width};
+        float corner_y[4] = {object->center_y - half_height, object->center_y - half_height,
+            object->center_y + half_height, object->center_y + half_height};
+
+        // the projected box is the bounding box of the projected corners
+        struct detection_fusion_box_struct *box = &fusion->box[fusion->box_num];
+        bool is_valid = true;
+        for(uint8_t c = 0; c < 4; c++)
+        {
+            float w = h[6] * corner_x[c] + h[7] * corner_y[c] + h[8];
+            if(w <= 0)
+            {   // behind the reference view
+                is_valid = false;
+                break;
+            }
+            float x = (h[0] * corner_x[c] + h[1] * corner_y[c] + h[2]) / w;
+            float y = (h[3] * corner_x[c] + h[4] * corner_y[c] + h[5]) / w;
+            if(c == 0 || x < box->x0)
+                box->x0 = x;
+            if(c == 0 || x > box->x1)
+                box->x1 = x;
+            if(c == 0 || y < box->y0)
+                box->y0 = y;
+            if(c == 0 || y > box->y1)
+                box->y1 = y;
+        }
+        if(!is_valid)
+            continue;
+
+        if(box->x0 < 0)
+            box->x0 = 0;
+        if(box->y0 < 0)
+            box->y0 = 0;
+        if(box->x1 > fusion->config.output_width)
+            box->x1 = fusion->config.output_width;
+        if(box->y1 > fusion->config.output_height)
+            box->y1 = fusion->config.output_height;
+        if(box->x1 <= box->x0 || box->y1 <= box->y0)
+            continue;   // outside of the reference view
+
+        box->object_type = object->object_type;
+        box->confidence_level = object->confidence_level;
+        box->module = module;
+        fusion->box_num++;
+    }
+}
+
+static bool is_overlapped(const struct detection_fusion_box_struct *a, const struct detection_fusion_box_struct *b, uint8_t iou_threshold_percent)
+{
+    float width = (a->x1 < b->x1 ? a->x1 : b->x1) - (a->x0 > b->x0 ? a->x0 : b->x0);
+    float height = (a->y1 < b->y1 ? a->y1 : b->y1) - (a->y0 > b->y0 ? a->y0 : b->y0);
+    if(width <= 0 || height <= 0)
+        return false;
+
+    float intersection = width * height;
+    float area_union = (a->x1 - a->x0) * (a->y1 - a->y0) + (b->x1 - b->x0) * (b->y1 - b->y0) - intersection;
+    return intersection * 100 > area_union * iou_threshold_percent;
+}
+
+static void give_fused_result(struct detection_fusion_struct *fusion)
+{
+    struct od_data_struct fused;
+    uint16_t order[DETECTION_FUSION_MAX_BOXES];
+    int16_t cell_first[DETECTION_FUSION_MAX_CELLS];
+    int16_t cell_next[DETECTION_FUSION_MAX_BOXES];
+    uint16_t columns = (fusion->config.output_width + (1 << DETECTION_FUSION_CELL_SHIFT) - 1) >> DETECTION_FUSION_CELL_SHIFT;
+    uint16_t rows = (fusion->config.output_height + (1 << DETECTION_FUSION_CELL_SHIFT) - 1) >> DETECTION_FUSION_CELL_SHIFT;
+    float max_half_width = 0, max_half_height = 0;     // of the kept boxes
+
+    // boxes by decreasing confidence level
+    for(uint16_t i = 0; i < fusion->box_num; i++)
+    {
+        uint16_t k = i;
+        for(; k > 0 && fusion->box[order[k - 1]].confidence_level < fusion->box[i].confidence_level; k--)
+            order[k] = order[k - 1];
+        order[k] = i;
+    }
+
+    // keep a box unless a kept box of the same type from another module overlaps it,
+    // the kept boxes are indexed by the cell of their center
+    memset(fused.object, 0, sizeof(fused.object));
+    fused.object_num = 0;
+    fused.reserve = 0;
+    for(uint16_t c = 0; c < columns * rows; c++)
+        cell_first[c] = NO_BOX;
+    for(uint16_t i = 0; i < fusion->box_num; i++)
+    {
+        const struct detection_fusion_box_struct *box = &fusion->box[order[i]];
+
+        // cells where the center of an overlapping kept box may be
+        int first_column = (int)(box->x0 - max_half_width) >> DETECTION_FUSION_CELL_SHIFT;
+        int last_column = (int)(box->x1 + max_half_width) >> DETECTION_FUSION_CELL_SHIFT;
+        int first_row = (int)(box->y0 - max_half_height) >> DETECTION_FUSION_CELL_SHIFT;
+        int last_row = (int)(box->y1 + max_half_height) >> DETECTION_FUSION_CELL_SHIFT;
+        if(first_column < 0)
+            first_column = 0;
+        if(first_row < 0)
+            first_row = 0;
+        if(last_column >= columns)
+            last_column = columns - 1;
+        if(last_row >= rows)
+            last_row = rows - 1;
+
+        bool is_duplicate = false;
+        for(int row = first_row; row <= last_row && !is_duplicate; row++)
+        {
+            for(int column = first_column; column <= last_column && !is_duplicate; column++)
+            {
+                for(int16_t k = cell_first[row * columns + column]; k != NO_BOX; k = cell_next[k])
+                {
+                    const struct detection_fusion_box_struct *kept = &fusion->box[k];
+                    if(kept->object_type == box->object_type && kept->module != box->module
+                        && is_overlapped(kept, box, fusion->config.iou_threshold_percent))
+                    {
+                        is_duplicate = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if(is_duplicate)
+        {
+            fusion->stats.boxes_suppressed++;
+            continue;
+        }
+
+        float center_x = (box->x0 + box->x1) * 0.5f, center_y = (box->y0 + box->y1) * 0.5f;
+        uint16_t cell = ((int)center_y >> DETECTION_FUSION_CELL_SHIFT) * columns + ((int)center_x >> DETECTION_FUSION_CELL_SHIFT);
+        if(cell >= columns * rows)
+            cell = columns * rows - 1;
+        cell_next[order[i]] = cell_first[cell];
+        cell_first[cell] = order[i];
+        if((box->x1 - box->x0) * 0.5f > max_half_width)
+            max_half_width = (box->x1 - box->x0) * 0.5f;
+        if((box->y1 - box->y0) * 0.5f > max_half_height)
+            max_half_height = (box->y1 - box->y0) * 0.5f;
+
+        if(fused.object_num < MAX_OD_SUPPORT_OBJECTS)
+        {   // the least confident objects are left out of a full result
+            struct od_object_unit_struct *object = &fused.object[fused.object_num++];
+            object->center_x = (uint32_t)(center_x + 0.5f);
+            object->center_y = (uint32_t)(center_y + 0.5f);
+            object->width = (uint32_t)(box->x1 - box->x0 + 0.5f);
+            object->height = (uint32_t)(box->y1 - box->y0 + 0.5f);
+            object->object_type = box->object_type;
+            object->confidence_level = box->confidence_level;
+        }
+    }
+
+    fusion->stats.results_out++;
+    fusion->stats.boxes_out += fused.object_num;
+    fusion->is_open = false;
+    fusion->is_given = true;
+    fusion->given_capture_us = fusion->open_capture_us;
+    if(fusion->fused_func != NULL)
+        fusion->fused_func(&fused, fusion->open_capture_us, fusion->module_mask);
+}
+
+bool detection_fusion_feed(struct detection_fusion_struct *fusion, uint8_t module, const struct od_data_struct *od_result,
+    const struct ai_module_frame_markers_struct *markers, uint32_t host_us)
+{
+    if(module >= fusion->config.module_num)
+        return false;
+
+    detection_fusion_poll(fusion, host_us);
+    uint32_t capture_us = estimate_capture_time(fusion, module, markers, host_us);
+    if(fusion->is_given && (int32_t)(capture_us - fusion->given_capture_us) <= (int32_t)fusion->config.align_window_us)
+    {   // captured with or before the last fused result given, its boxes would be given twice
+        fusion->stats.results_late++;
+        return false;
+    }
+    if(fusion->is_open)
+    {
+        int32_t delta_us = (int32_t)(capture_us - fusion->open_capture_us);
+        if(delta_us < -(int32_t)fusion->config.align_window_us)
+        {   // the fused result of its capture time has already been given
+            fusion->stats.results_late++;
+            return false;
+        }
+        if(delta_us > (int32_t)fusion->config.align_window_us || (fusion->module_mask & (1 << module)) != 0)
+            give_fused_result(fusion);
+    }
+
+    if(!fusion->is_open)
+    {
+        fusion->is_open = true;
+        fusion->open_capture_us = capture_us;
+        fusion->open_host_us = host_us;
+        fusion->module_mask = 0;
+        fusion->box_num = 0;
+    }
+    add_boxes(fusion, module, od_result);
+    fusion->module_mask |= 1 << module;
+    fusion->stats.results_in++;
+    fusion->stats.boxes_in += od_result->object_num;
+
+    if(fusion->module_mask == (1 << fusion->config.module_num) - 1)
+        give_fused_result(fusion);  // every module reported
+    return true;
+}
+
+void detection_fusion_poll(struct detection_fusion_struct *fusion, uint32_t now_us)
+{
+    if(fusion->is_open && now_us - fusion->open_host_us >= fusion->config.max_latency_us)
+        give_fused_result(fusion);
+}
+
+void detection_fusion_get_stats(const struct detection_fusion_struct *fusion, struct detection_fusion_stats_struct *stats)
+{
+    *stats = fusion->stats;
+}
@@ -0,0 +1,162 @@
+/** InstAI Co. (Public Version)
+    Description: Fusion of the OD results of several AI modules with overlapping views into a single deduplicated detection stream
+    Modified Date: Oct 19, 2026
+    Remark: the OD results of each module are projected into a common reference view through the module homography,
+        their capture times are estimated from the host timestamps and the module frame counters, and the results
+        captured within the alignment window are merged by a class-aware non-maximum suppression between modules,
+        indexed by a grid of the reference view so that each box is only compared with the boxes around it
+*/
+
+#ifndef DETECTION_FUSION_H
+#define DETECTION_FUSION_H
+
+#include "ai_module.h"
+
+//-- Constant values
+#define DETECTION_FUSION_MAX_MODULES    4
+#define DETECTION_FUSION_MAX_BOXES      (DETECTION_FUSION_MAX_MODULES * MAX_OD_SUPPORT_OBJECTS)
+#define DETECTION_FUSION_CELL_SHIFT     5       // cells of the suppression grid are 32x32 pixels of the reference view
+#define DETECTION_FUSION_MAX_CELLS      512     // cells of the suppression grid (e.g. 640x480 reference view)
+
+//-- Structures
+/**
+    @brief: settings of the fusion
+    @remark: call detection_fusion_default_config() to fill the default values before customizing the settings
+*/
+struct detection_fusion_config_struct {
+    uint8_t module_num;
+    // row-major 3x3 homography mapping the pixels of each module (320x240) to the reference view
+    float homography[DETECTION_FUSION_MAX_MODULES][9];
+    uint16_t output_width;          // size of the reference view, the projected boxes are clipped to it
+    uint16_t output_height;
+    uint32_t frame_period_us;       // capture period of the modules
+    uint32_t align_window_us;       // results captured within this time are fused (e.g. half the frame period)
+    uint32_t max_latency_us;        // time waiting for the results of the other modules before the fused result is given
+    uint8_t iou_threshold_percent;  // boxes of the same type from different modules overlapping more than this are one object
+};
+
+/**
+    @brief: a projected box waiting to be fused
+*/
+struct detection_fusion_box_struct {
+    float x0, y0, x1, y1;           // corners in the reference view
+    uint8_t object_type;
+    uint8_t confidence_level;
+    uint8_t module;
+};
+
+/**
+    @brief: capture time estimation of a module
+*/
+struct detection_fusion_clock_struct {
+    bool is_valid;
+    uint32_t offset_us;             // host time of frame 0 (modulo 2^32), smallest value observed in the current and previous windows
+    uint32_t window_offset_us;
+    uint32_t window_start_us;
+};
+
+/**
+    @brief: statistics of the fusion
+*/
+struct detection_fusion_stats_struct {
+    uint64_t results_in;            // OD results fed
+    uint64_t boxes_in;
+    uint64_t results_out;           // fused results given
+    uint64_t boxes_out;
+    uint64_t boxes_suppressed;      // duplicates between modules
+    uint64_t results_late;          // OD results captured before the fused result being built or given (dropped)
+};
+
+//-- Function Pointer
+/**
+    @brief: function pointer which points to custom function receiving the fused results
+    @parameter:
+        od_result:      fused OD result, coordinates in the reference view
+        capture_us:     estimated host time (interface_micros()) of the capture
+        module_mask:    bit (module index) set for each module which contributed to the result
+*/
+typedef void (*FunPtr_FusedResult)(const struct od_data_struct *od_result, uint32_t capture_us, uint8_t module_mask);
+
+/**
+    @brief: state of the fusion
+*/
+struct detection_fusion_struct {
+    struct detection_fusion_config_struct config;
+    struct detection_fusion_clock_struct clock[DETECTION_FUSION_MAX_MODULES];
+    struct detection_fusion_box_struct box[DETECTION_FUSION_MAX_BOXES];
+    uint16_t box_num;
+    bool is_open;                   // a fused result is being built
+    uint32_t open_capture_us;       // capture time of the first result of the fused result
+    uint32_t open_host_us;          // host time the first result was fed
+    uint8_t module_mask;
+    bool is_given;                  // a fused result has been given
+    uint32_t given_capture_us;      // capture time of the last fused result given
+    FunPtr_FusedResult fused_func;
+    struct detection_fusion_stats_struct stats;
+};
+
+/**
+    @brief: fill the default settings
+    @parameter:
+        config:     give the variable with type "detection_fusion_config_struct" to store the settings
+        module_num: number of modules, up to DETECTION_FUSION_MAX_MODULES
+    @return:
+        (NONE)
+    @remark: identity homographies with a 320x240 reference view, 10 frames per second, 50 ms alignment window,
+        100 ms latency and 50% IoU threshold
+*/
+void detection_fusion_default_config(struct detection_fusion_config_struct *config, uint8_t module_num);
+
+/**
+    @brief: initialize the fusion
+    @parameter:
+        fusion:     the fusion to initialize
+        config:     settings of the fusion
+        fused_func: function with prototype void [Custom_Function_Name](const struct od_data_struct *od_result, uint32_t capture_us,
+                    uint8_t module_mask);
+    @return:
+        return true if the fusion is initialized
+        otherwise, return false (invalid number of modules or reference view larger than DETECTION_FUSION_MAX_CELLS cells)
+*/
+bool detection_fusion_init(struct detection_fusion_struct *fusion, const struct detection_fusion_config_struct *config,
+    FunPtr_FusedResult fused_func);
+
+/**
+    @brief: feed the OD result of a module
+    @parameter:
+        fusion:         the fusion
+        module:         index of the module
+        od_result:      OD result retrieved by ai_module_process_event()
+        markers:        frame markers retrieved by ai_module_get_frame_markers() after the event, NULL if unavailable
+                        (the capture time is then the host time)
+        host_us:        interface_micros() time the OD result was retrieved
+    @return:
+        return true if the OD result is accepted
+        otherwise, return false (invalid module, or result belonging to a fused result already given)
+    @remark: the fused results which are complete are given to the registered function first
+*/
+bool detection_fusion_feed(struct detection_fusion_struct *fusion, uint8_t module, const struct od_data_struct *od_result,
+    const struct ai_module_frame_markers_struct *markers, uint32_t host_us);
+
+/**
+    @brief: give the fused result being built once the modules had the time to report their results
+    @parameter:
+        fusion:     the fusion
+        now_us:     current time given by interface_micros()
+    @return:
+        (NONE)
+    @remark: call it from the main loop
+*/
+void detection_fusion_poll(struct detection_fusion_struct *fusion, uint32_t now_us);
+
+/**
+    @brief: get the statistics of the fusion
+    @parameter:
+        fusion: the fusion
+        stats:  give the variable with type "detection_fusion_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void detection_fusion_get_stats(const struct detection_fusion_struct *fusion, struct detection_fusion_stats_struct *stats);
+
+#endif // DETECTION_FUSION_H
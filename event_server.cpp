@@ -0,0 +1,459 @@
+/** InstAI Co. (Public Version)
+    Description: Unix domain socket server streaming OD results and JPEGs to local client processes
+    Modified Date: Oct 19, 2026
+*/
+#include "event_server.h"
+
+#ifdef PLATFORM_POSIX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+//-- Constant values
+#define SUBSCRIBE_BODY_SIZE 6       // type_mask, min_confidence, flags
+#define RX_BUFFER_SIZE      64
+#define MAX_IOV_PER_WRITE   64
+
+//-- Structure
+// JPEG shared by the queues of all clients, released when the last client has sent it
+struct shared_payload_struct
+{
+    uint32_t refs;
+    size_t size;
+    uint8_t data[1];
+};
+
+struct queue_entry_struct
+{
+    uint8_t header[EVENT_SERVER_MAX_HEADER_SIZE];
+    uint16_t header_size;
+    struct shared_payload_struct *payload;
+};
+
+struct client_struct
+{
+    int fd;
+    uint32_t type_mask;
+    uint8_t min_confidence;
+    uint8_t flags;
+    uint8_t rx_buffer[RX_BUFFER_SIZE];
+    uint8_t rx_size;
+    struct queue_entry_struct queue[EVENT_SERVER_QUEUE_SIZE];
+    uint8_t queue_head;
+    uint8_t queue_num;
+    size_t head_sent;               // bytes of the head entry already sent
+    bool queue_full;
+    uint32_t full_since_ms;         // time when the queue became full
+};
+
+/* ---- internal function prototypes declaration ---- */
+static uint32_t get_time_ms();
+static uint64_t get_timestamp_us();
+static void put_u16(uint8_t *p, uint16_t v);
+static void put_u32(uint8_t *p, uint32_t v);
+static void put_u64(uint8_t *p, uint64_t v);
+static void release_payload(struct shared_payload_struct *payload);
+static void close_client(struct client_struct *client, bool by_server);
+static uint16_t build_header(struct client_struct *client, enum EVENT_SERVER_MSG type, uint64_t seq, uint64_t timestamp_us,
+    const struct od_data_struct *od_result, size_t payload_size, uint8_t *header);
+static void enqueue(struct client_struct *client, enum EVENT_SERVER_MSG type, uint64_t seq, uint64_t timestamp_us,
+    const struct od_data_struct *od_result, struct shared_payload_struct *payload);
+static void accept_clients();
+static void read_client(struct client_struct *client);
+static void flush_client(struct client_struct *client);
+
+//-- Global variables
+static int listen_fd = -1;
+static char listen_path[108] = { 0 };
+static struct client_struct clients[EVENT_SERVER_MAX_CLIENTS];
+static uint64_t message_seq = 0;
+static struct event_server_stats_struct server_stats;
+
+static uint32_t get_time_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static uint64_t get_timestamp_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for(uint8_t i = 0; i < 4; i++)
+        p[i] = (v >> (8 * i)) & 0xff;
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+    for(uint8_t i = 0; i < 8; i++)
+        p[i] = (v >> (8 * i)) & 0xff;
+}
+
+bool event_server_open(const char *socket_path, mode_t mode)
+{
+    struct sockaddr_un addr;
+
+    event_server_close();
+
+    if(strlen(socket_path) >= sizeof(addr.sun_path))
+        return false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(listen_fd < 0)
+        return false;
+
+    unlink(socket_path);
+    if(bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || chmod(socket_path, mode) != 0 ||
+        listen(listen_fd, EVENT_SERVER_MAX_CLIENTS) != 0)
+    {
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(socket_path);
+        return false;
+    }
+
+    strcpy(listen_path, socket_path);
+    memset(clients, 0, sizeof(clients));
+    for(uint8_t i = 0; i < EVENT_SERVER_MAX_CLIENTS; i++)
+        clients[i].fd = -1;
+    memset(&server_stats, 0, sizeof(struct event_server_stats_struct));
+    return true;
+}
+
+void event_server_close()
+{
+    if(listen_fd < 0)
+        return;
+
+    for(uint8_t i = 0; i < EVENT_SERVER_MAX_CLIENTS; i++)
+        if(clients[i].fd >= 0)
+            close_client(&clients[i], false);
+
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(listen_path);
+    memset(listen_path, 0, sizeof(listen_path));
+}
+
+static void release_payload(struct shared_payload_struct *payload)
+{
+    if(payload != NULL && --payload->refs == 0)
+        free(payload);
+}
+
+static void close_client(struct client_struct *client, bool by_server)
+{
+    for(uint8_t i = 0; i < client->queue_num; i++)
+        release_payload(client->queue[(client->queue_head + i) % EVENT_SERVER_QUEUE_SIZE].payload);
+
+    close(client->fd);
+    memset(client, 0, sizeof(struct client_struct));
+    client->fd = -1;
+    server_stats.clients--;
+    if(by_server)
+        server_stats.clients_disconnected++;
+}
+
+static uint16_t build_header(struct client_struct *client, enum EVENT_SERVER_MSG type, uint64_t seq, uint64_t timestamp_us,
+    const struct od_data_struct *od_result, size_t payload_size, uint8_t *header)
+{
+    uint8_t object_num = 0;
+    uint16_t size = 4 + 1 + 8 + 8 + 1;
+
+    // only the objects matching the client subscription
+    for(uint8_t i = 0; od_result != NULL && i < od_result->object_num && i < MAX_OD_SUPPORT_OBJECTS; i++)
+    {
+        const struct od_object_unit_struct *object = &od_result->object[i];
+        if(object->object_type >= 32 || !(client->type_mask & (1u << object->object_type)) ||
+            object->confidence_level < client->min_confidence)
+            continue;
+
+        uint8_t *p = &header[size];
+        put_u16(&p[0], (uint16_t)object->center_x);
+        put_u16(&p[2], (uint16_t)object->center_y);
+        put_u16(&p[4], (uint16_t)object->width);
+        put_u16(&p[6], (uint16_t)object->height);
+        p[8] = object->object_type;
+        p[9] = object->confidence_level;
+        size += EVENT_SERVER_OBJECT_SIZE;
+        object_num++;
+    }
+
+    // an OD result (or a JPEG with OD result) without any wanted object is not sent
+    if(od_result != NULL && object_num == 0)
+        return 0;
+
+    header[4] = (uint8_t)type;
+    put_u64(&header[5], seq);
+    put_u64(&header[13], timestamp_us);
+    header[21] = object_num;
+    if(type == EVENT_SERVER_MSG_JPEG)
+    {
+        put_u32(&header[size], (uint32_t)payload_size);
+        size += 4;
+    }
+    put_u32(&header[0], (uint32_t)(size - 4 + payload_size));
+    return size;
+}
+
+static void enqueue(struct client_struct *client, enum EVENT_SERVER_MSG type, uint64_t seq, uint64_t timestamp_us,
+    const struct od_data_struct *od_result, struct shared_payload_struct *payload)
+{
+    if(client->queue_num >= EVENT_SERVER_QUEUE_SIZE)
+    {   // slow client: drop the message rather than blocking the bus thread
+        if(!client->queue_full)
+        {
+            client->queue_full = true;
+            client->full_since_ms = get_time_ms();
+        }
+        server_stats.messages_dropped++;
+        return;
+    }
+
+    struct queue_entry_struct *entry = &client->queue[(client->queue_head + client->queue_num) % EVENT_SERVER_QUEUE_SIZE];
+    entry->header_size = build_header(client, type, seq, timestamp_us, od_result, payload != NULL ? payload->size : 0, entry->header);
+    if(entry->header_size == 0)
+        return;
+
+    entry->payload = payload;
+    if(payload != NULL)
+        payload->refs++;
+    client->queue_num++;
+}
+
+void event_server_publish_od(const struct od_data_struct *od_result)
+{
+    if(listen_fd < 0)
+        return;
+
+    uint64_t seq = ++message_seq;
+    uint64_t timestamp_us = get_timestamp_us();
+    for(uint8_t i = 0; i < EVENT_SERVER_MAX_CLIENTS; i++)
+        if(clients[i].fd >= 0)
+            enqueue(&clients[i], EVENT_SERVER_MSG_OD, seq, timestamp_us, od_result, NULL);
+}
+
+void event_server_publish_jpeg(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_data_struct *od_result)
+{
+    struct shared_payload_struct *payload = NULL;
+
+    if(listen_fd < 0)
+        return;
+
+    uint64_t seq = ++message_seq;
+    uint64_t timestamp_us = get_timestamp_us();
+    for(uint8_t i = 0; i < EVENT_SERVER_MAX_CLIENTS; i++)
+    {
+        if(clients[i].fd < 0 || !(clients[i].flags & EVENT_SERVER_FLAG_JPEG))
+            continue;
+
+        // copy the JPEG once, only if at least one client wants it
+        if(payload == NULL)
+        {
+            payload = (struct shared_payload_struct *)malloc(sizeof(struct shared_payload_struct) + jpeg_size);
+            if(payload == NULL)
+                return;
+            payload->refs = 1;      // held by this function until all clients are served
+            payload->size = jpeg_size;
+            memcpy(payload->data, jpeg_data, jpeg_size);
+        }
+        enqueue(&clients[i], EVENT_SERVER_MSG_JPEG, seq, timestamp_us, od_result, payload);
+    }
+    release_payload(payload);
+}
+
+static void accept_clients()
+{
+    while(1)
+    {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0)
+            return;
+
+        uint8_t i;
+        for(i = 0; i < EVENT_SERVER_MAX_CLIENTS; i++)
+            if(clients[i].fd < 0)
+                break;
+        if(i == EVENT_SERVER_MAX_CLIENTS)
+        {
+            close(fd);
+            continue;
+        }
+
+        memset(&clients[i], 0, sizeof(struct client_struct));
+        clients[i].fd = fd;
+        clients[i].type_mask = 0xFFFFFFFF;  // every OD result without JPEG until the client subscribes
+        server_stats.clients++;
+    }
+}
+
+static void read_client(struct client_struct *client)
+{
+    while(1)
+    {
+        ssize_t n = recv(client->fd, &client->rx_buffer[client->rx_size], RX_BUFFER_SIZE - client->rx_size, 0);
+        if(n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+            close_client(client, false);
+            return;
+        }
+        if(n < 0)
+            return;
+        client->rx_size += n;
+
+        // parse complete messages
+        while(client->rx_size >= 5)
+        {
+            uint32_t length = client->rx_buffer[0] | (client->rx_buffer[1] << 8) | (client->rx_buffer[2] << 16) | ((uint32_t)client->rx_buffer[3] << 24);
+            if(length == 0 || length > RX_BUFFER_SIZE - 4)
+            {
+                close_client(client, true);
+                return;
+            }
+            if(client->rx_size < 4 + length)
+                break;
+
+            if(client->rx_buffer[4] == EVENT_SERVER_MSG_SUBSCRIBE && length >= 1 + SUBSCRIBE_BODY_SIZE)
+            {
+                uint8_t *body = &client->rx_buffer[5];
+                client->type_mask = body[0] | (body[1] << 8) | (body[2] << 16) | ((uint32_t)body[3] << 24);
+                client->min_confidence = body[4];
+                client->flags = body[5];
+            }
+            memmove(client->rx_buffer, &client->rx_buffer[4 + length], client->rx_size - 4 - length);
+            client->rx_size -= 4 + length;
+        }
+    }
+}
+
+static void flush_client(struct client_struct *client)
+{
+    while(client->queue_num > 0)
+    {
+        struct iovec iov[MAX_IOV_PER_WRITE];
+        int iov_num = 0;
+        size_t skip = client->head_sent;
+
+        // batch all queued messages into a single scatter-gather write
+        for(uint8_t i = 0; i < client->queue_num && iov_num + 2 <= MAX_IOV_PER_WRITE; i++)
+        {
+            struct queue_entry_struct *entry = &client->queue[(client->queue_head + i) % EVENT_SERVER_QUEUE_SIZE];
+            if(skip < entry->header_size)
+            {
+                iov[iov_num].iov_base = &entry->header[skip];
+                iov[iov_num].iov_len = entry->header_size - skip;
+                iov_num++;
+                skip = 0;
+            }
+            else
+                skip -= entry->header_size;
+
+            if(entry->payload != NULL)
+            {
+                iov[iov_num].iov_base = &entry->payload->data[skip];
+                iov[iov_num].iov_len = entry->payload->size - skip;
+                iov_num++;
+            }
+            skip = 0;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_num;
+        ssize_t n = sendmsg(client->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        server_stats.write_calls++;
+        if(n < 0)
+        {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                close_client(client, false);
+            break;
+        }
+        server_stats.bytes_sent += n;
+
+        // release the completely sent messages
+        size_t sent = client->head_sent + n;
+        while(client->queue_num > 0)
+        {
+            struct queue_entry_struct *entry = &client->queue[client->queue_head];
+            size_t entry_size = entry->header_size + (entry->payload != NULL ? entry->payload->size : 0);
+            if(sent < entry_size)
+                break;
+            sent -= entry_size;
+            release_payload(entry->payload);
+            entry->payload = NULL;
+            client->queue_head = (client->queue_head + 1) % EVENT_SERVER_QUEUE_SIZE;
+            client->queue_num--;
+            server_stats.messages_sent++;
+        }
+        client->head_sent = sent;
+        client->queue_full = false;
+    }
+
+    // a client which does not read anymore is disconnected so that it does not hold memory forever
+    if(client->fd >= 0 && client->queue_full && get_time_ms() - client->full_since_ms > EVENT_SERVER_STALL_TIMEOUT_MS)
+        close_client(client, true);
+}
+
+void event_server_poll()
+{
+    struct pollfd fds[EVENT_SERVER_MAX_CLIENTS + 1];
+    uint8_t index[EVENT_SERVER_MAX_CLIENTS];
+    nfds_t fd_num = 0;
+
+    if(listen_fd < 0)
+        return;
+
+    fds[fd_num].fd = listen_fd;
+    fds[fd_num].events = POLLIN;
+    fd_num++;
+    for(uint8_t i = 0; i < EVENT_SERVER_MAX_CLIENTS; i++)
+    {
+        if(clients[i].fd < 0)
+            continue;
+        index[fd_num - 1] = i;
+        fds[fd_num].fd = clients[i].fd;
+        fds[fd_num].events = POLLIN;
+        fd_num++;
+    }
+
+    // never wait, the bus thread only serves what is ready
+    if(poll(fds, fd_num, 0) > 0)
+    {
+        for(nfds_t i = 1; i < fd_num; i++)
+            if(fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                read_client(&clients[index[i - 1]]);
+        if(fds[0].revents & POLLIN)
+            accept_clients();
+    }
+
+    for(uint8_t i = 0; i < EVENT_SERVER_MAX_CLIENTS; i++)
+        if(clients[i].fd >= 0 && clients[i].queue_num > 0)
+            flush_client(&clients[i]);
+}
+
+void event_server_get_stats(struct event_server_stats_struct *stats)
+{
+    memcpy(stats, &server_stats, sizeof(struct event_server_stats_struct));
+}
+
+#endif // PLATFORM_POSIX
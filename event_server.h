@@ -0,0 +1,134 @@
+/** InstAI Co. (Public Version)
+    Description: Unix domain socket server streaming OD results and JPEGs to local client processes
+    Modified Date: Oct 19, 2026
+    Remark: requires a POSIX platform, the server is served from the thread owning the AI module and never blocks it:
+        messages are queued per client, batched and sent with scatter-gather writes on non-blocking sockets,
+        a client which cannot keep up loses the messages that do not fit in its queue
+*/
+
+#ifndef EVENT_SERVER_H
+#define EVENT_SERVER_H
+
+#include "ai_module.h"
+
+#ifdef PLATFORM_POSIX
+#include <sys/types.h>
+
+/**
+    Protocol (little endian), every message is framed as:
+        length (4 bytes, size of the following type + body), type (1 byte), body
+
+    client -> server:
+        EVENT_SERVER_MSG_SUBSCRIBE: type_mask (4 bytes, bit n set = object type n wanted), min_confidence (1 byte),
+            flags (1 byte, EVENT_SERVER_FLAG_*)
+            a new client receives every OD result without JPEG until it subscribes
+    server -> client:
+        EVENT_SERVER_MSG_OD:   seq (8 bytes), timestamp_us (8 bytes), object_num (1 byte),
+            object_num * [center_x, center_y, width, height (2 bytes each), object_type, confidence_level (1 byte each)]
+        EVENT_SERVER_MSG_JPEG: same body as EVENT_SERVER_MSG_OD, followed by jpeg_size (4 bytes) and the JPEG data
+    only the objects matching the client subscription are sent, OD results without matching object are not sent
+*/
+
+//-- Constant values
+#define EVENT_SERVER_MAX_CLIENTS        16
+#define EVENT_SERVER_QUEUE_SIZE         64          // messages queued per client
+#define EVENT_SERVER_STALL_TIMEOUT_MS   10000       // disconnect a client whose queue stays full for this long
+#define EVENT_SERVER_OBJECT_SIZE        10
+#define EVENT_SERVER_MAX_HEADER_SIZE    (4 + 1 + 8 + 8 + 1 + MAX_OD_SUPPORT_OBJECTS * EVENT_SERVER_OBJECT_SIZE + 4)
+
+//-- Enumerations
+/**
+    @brief: message types of the protocol
+*/
+enum EVENT_SERVER_MSG
+{
+    EVENT_SERVER_MSG_OD = 0x01,
+    EVENT_SERVER_MSG_JPEG = 0x02,
+    EVENT_SERVER_MSG_SUBSCRIBE = 0x10
+};
+
+/**
+    @brief: flags of EVENT_SERVER_MSG_SUBSCRIBE
+*/
+enum EVENT_SERVER_FLAG
+{
+    EVENT_SERVER_FLAG_JPEG = 0x01       // also send the JPEGs (as EVENT_SERVER_MSG_JPEG)
+};
+
+//-- Structures
+/**
+    @brief: statistics of the event server
+*/
+struct event_server_stats_struct {
+    uint32_t clients;               // currently connected clients
+    uint64_t messages_sent;
+    uint64_t messages_dropped;      // messages not queued because a client queue was full
+    uint64_t bytes_sent;
+    uint64_t write_calls;           // scatter-gather write system calls
+    uint32_t clients_disconnected;  // clients closed by the server (protocol error or stalled)
+};
+
+/**
+    @brief: start listening on the Unix domain socket
+    @parameter:
+        socket_path:    file system path of the socket, an existing socket file is replaced
+        mode:           access permission of the socket file (e.g. 0666 to accept clients of any user)
+    @return:
+        return true if the server is listening
+        otherwise, return false
+*/
+bool event_server_open(const char *socket_path, mode_t mode);
+
+/**
+    @brief: disconnect all clients and remove the socket
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+*/
+void event_server_close();
+
+/**
+    @brief: queue an OD result for the subscribed clients
+    @parameter:
+        od_result: OD result retrieved by ai_module_process_event()
+    @return:
+        (NONE)
+    @remark: the message is sent by the next call of event_server_poll()
+*/
+void event_server_publish_od(const struct od_data_struct *od_result);
+
+/**
+    @brief: queue a JPEG for the clients subscribed to JPEGs
+    @parameter:
+        jpeg_data:  JPEG data provided by the save JPEG function
+        jpeg_size:  size of JPEG data
+        od_result:  OD result of the JPEG, or NULL
+    @return:
+        (NONE)
+    @remark: the JPEG is copied once and shared by all client queues
+*/
+void event_server_publish_jpeg(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_data_struct *od_result);
+
+/**
+    @brief: accept new clients, read their subscriptions and send the queued messages
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+    @remark: never blocks, call it once per main loop iteration
+*/
+void event_server_poll();
+
+/**
+    @brief: get the statistics of the event server
+    @parameter:
+        stats: give the variable with type "event_server_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void event_server_get_stats(struct event_server_stats_struct *stats);
+
+#endif // PLATFORM_POSIX
+
+#endif // EVENT_SERVER_H
@@ -0,0 +1,385 @@
+/** InstAI Co. (Public Version)
+    Description: Scriptable register-level fake AI module serving the driver on a simulated host
+    Modified Date: Oct 19, 2026
+*/
+#include "fake_module.h"
+
+#ifdef PLATFORM_HOST_SIM
+
+//-- Registers (register map of the AI module, see ai_module.cpp)
+#define R_FW_POWER_ON_READY_0 0x03
+#define R_INTO_STATUS 0x04
+#define R_CPU_RESET_ENL 0x0A
+#define R_RPT_SRAM_DATA_REG 0x0F
+#define R_OP_MODE_HOST 0x10
+#define R_OP_HOST_REQ 0x21
+#define R_OP_HOST_PARA 0x22
+#define R_OP_HOST_PARA0_REG 0x23
+#define R_OP_HOST_PARA1_REG 0x24
+#define CPU_VALID_CONTROL 0x3B
+#define BANK_SEL 0x7F
+#define OD_THRESHOLD_BANK 14
+#define R_OD_THRESHOLD_BASE 74
+
+//-- Parameters for R_OP_HOST_REQ register
+#define REQ_DATA_INIT 0x03
+#define REQ_DATA_REQUEST 0x04
+#define REQ_STATE_CLR 0x05
+
+//-- Constant values
+#define READY_EVENT 0x01
+#define DATA_DESCRIPTION_SIZE 32
+#define OD_PAYLOAD_SIZE (2 + 10 * MAX_OD_SUPPORT_OBJECTS)
+#define FRAME_RING_DEPTH 15     // frames kept by the module before the current one
+#define MOTION_ONSET_FRAMES 3   // frames between the motion onset and the OD frame
+#define TINDEX_DEFAULT 1024
+
+/* ---- internal function prototypes declaration ---- */
+static uint8_t fake_read(uint8_t address);
+static void fake_write(uint8_t address, uint8_t data);
+static void transfer_delay();
+static void raise_due_events();
+static void execute_request(uint8_t request);
+static void prepare_payload(uint8_t event_type);
+static void put_u32(uint8_t *data, uint32_t value);
+
+//-- Global variables
+static struct fake_module_config_struct fake_config;
+static const struct interface_sim_device fake_device = { fake_read, fake_write };
+static FunPtr_FakeModuleEventCleared cleared_func = NULL;
+static struct fake_module_stats_struct fake_stats;
+static uint64_t transfer_remainder_ns = 0;  // emulated transfer time not waited yet
+
+static struct fake_module_event_struct schedule[FAKE_MODULE_QUEUE_SIZE];
+static uint32_t schedule_head = 0, schedule_count = 0;
+
+static struct fake_module_event_struct pending;
+static bool has_pending = false;
+static uint32_t frame_counter = 0;
+
+static uint8_t bank = 0;
+static uint8_t registers[128];
+static uint8_t od_thresholds[MAX_OD_SUPPORT_TYPES];
+static uint8_t into_status = 0;
+static bool cpu_valid = false, power_on_ready = false;
+static uint8_t mode = IDLE_MODE;
+static uint8_t host_para = 0;
+static uint32_t tindex = 0;
+
+static uint8_t od_payload[OD_PAYLOAD_SIZE];
+static uint8_t jpeg_payload[AI_MODULE_BUFFER_SIZE];
+static const uint8_t *payload = NULL;
+static uint32_t payload_size = 0, payload_offset = 0;
+static uint8_t description[DATA_DESCRIPTION_SIZE];
+static const uint8_t *sram = NULL;
+static uint32_t sram_size = 0, sram_offset = 0;
+
+void fake_module_default_config(struct fake_module_config_struct *config)
+{
+    memset(config, 0, sizeof(struct fake_module_config_struct));
+    config->spi_clock_hz = 0;
+    config->max_size_per_packet = 4096;
+}
+
+const struct interface_sim_device *fake_module_init(const struct fake_module_config_struct *config)
+{
+    if(config != NULL)
+        memcpy(&fake_config, config, sizeof(struct fake_module_config_struct));
+    else
+        fake_module_default_config(&fake_config);
+    if(fake_config.max_size_per_packet == 0)
+        fake_config.max_size_per_packet = 4096;
+
+    memset(&fake_stats, 0, sizeof(fake_stats));
+    transfer_remainder_ns = 0;
+    schedule_head = schedule_count = 0;
+    has_pending = false;
+    frame_counter = 0;
+
+    bank = 0;
+    memset(registers, 0, sizeof(registers));
+    memset(od_thresholds, 0, sizeof(od_thresholds));
+    into_status = 0;
+    cpu_valid = power_on_ready = false;
+    mode = IDLE_MODE;
+    host_para = 0;
+    tindex = 0;
+    payload = sram = NULL;
+    payload_size = payload_offset = sram_size = sram_offset = 0;
+
+    return &fake_device;
+}
+
+void fake_module_register_cleared_func(FunPtr_FakeModuleEventCleared func)
+{
+    cleared_func = func;
+}
+
+bool fake_module_schedule_event(const struct fake_module_event_struct *event)
+{
+    if(schedule_count >= FAKE_MODULE_QUEUE_SIZE)
+        return false;
+
+    struct fake_module_event_struct *slot = &schedule[(schedule_head + schedule_count) % FAKE_MODULE_QUEUE_SIZE];
+    memcpy(slot, event, sizeof(struct fake_module_event_struct));
+    if(slot->jpeg_size > AI_MODULE_BUFFER_SIZE)
+        slot->jpeg_size = AI_MODULE_BUFFER_SIZE;
+    if(slot->od.object_num > MAX_OD_SUPPORT_OBJECTS)
+        slot->od.object_num = MAX_OD_SUPPORT_OBJECTS;
+
+    schedule_count++;
+    fake_stats.events_scheduled++;
+    if(schedule_count > fake_stats.queue_high_water)
+        fake_stats.queue_high_water = schedule_count;
+    return true;
+}
+
+uint32_t fake_module_scheduled_events()
+{
+    return schedule_count;
+}
+
+const struct fake_module_event_struct *fake_module_pending_event()
+{
+    return has_pending ? &pending : NULL;
+}
+
+void fake_module_get_stats(struct fake_module_stats_struct *stats)
+{
+    memcpy(stats, &fake_stats, sizeof(struct fake_module_stats_struct));
+}
+
+static void transfer_delay()
+{
+    if(fake_config.spi_clock_hz == 0)
+        return;
+
+    // address and data bytes are clocked out before the access completes,
+    // the fractions of microsecond are carried over to the next accesses
+    transfer_remainder_ns += 16ULL * 1000000000ULL / fake_config.spi_clock_hz;
+    if(transfer_remainder_ns >= 1000)
+    {
+        interface_delay_us((uint32_t)(transfer_remainder_ns / 1000));
+        transfer_remainder_ns %= 1000;
+    }
+}
+
+static void raise_due_events()
+{
+    uint32_t now_us = interface_micros();
+
+    while(schedule_count > 0)
+    {
+        struct fake_module_event_struct *event = &schedule[schedule_head];
+        if((int32_t)(now_us - event->due_us) < 0)
+            break;
+
+        if(has_pending)
+            fake_stats.events_lost++;   // the module keeps the uncleared event
+        else
+        {
+            memcpy(&pending, event, sizeof(struct fake_module_event_struct));
+            has_pending = true;
+            into_status |= pending.events;
+            frame_counter++;
+            fake_stats.events_raised++;
+        }
+
+        schedule_head = (schedule_head + 1) % FAKE_MODULE_QUEUE_SIZE;
+        schedule_count--;
+    }
+}
+
+static void put_u32(uint8_t *data, uint32_t value)
+{
+    for(uint8_t i = 0; i < 4; i++)
+        data[i] = (value >> (8 * i)) & 0xFF;
+}
+
+static void prepare_payload(uint8_t event_type)
+{
+    payload = NULL;
+    payload_size = payload_offset = 0;
+    if(!has_pending || (pending.events & event_type) == 0)
+        return;
+
+    if(event_type == FAKE_MODULE_OD_EVENT)
+    {
+        const struct od_data_struct *od = &pending.od;
+        memset(od_payload, 0, sizeof(od_payload));
+        od_payload[0] = od->object_num;
+        od_payload[1] = od->reserve;
+        for(uint8_t i = 0; i < od->object_num; i++)
+        {
+            uint8_t *unit = &od_payload[2 + 10 * i];
+            unit[0] = od->object[i].center_x & 0xFF;
+            unit[1] = (od->object[i].center_x >> 8) & 0xFF;
+            unit[2] = od->object[i].center_y & 0xFF;
+            unit[3] = (od->object[i].center_y >> 8) & 0xFF;
+            unit[4] = od->object[i].width & 0xFF;
+            unit[5] = (od->object[i].width >> 8) & 0xFF;
+            unit[6] = od->object[i].height & 0xFF;
+            unit[7] = (od->object[i].height >> 8) & 0xFF;
+            unit[8] = od->object[i].object_type;
+            unit[9] = od->object[i].confidence_level;
+        }
+        payload = od_payload;
+        payload_size = 2 + 10 * od->object_num;
+    }
+    else if(event_type == FAKE_MODULE_JPEG_EVENT)
+    {
+        // SOI marker, event id, frame index, filler, EOI marker
+        uint32_t size = pending.jpeg_size < 12 ? 12 : pending.jpeg_size;
+        jpeg_payload[0] = 0xFF;
+        jpeg_payload[1] = 0xD8;
+        put_u32(&jpeg_payload[2], pending.id);
+        put_u32(&jpeg_payload[6], tindex == TINDEX_DEFAULT ? frame_counter + FRAME_RING_DEPTH : tindex);
+        for(uint32_t i = 10; i < size - 2; i++)
+            jpeg_payload[i] = (uint8_t)(i * 31 + pending.id);
+        jpeg_payload[size - 2] = 0xFF;
+        jpeg_payload[size - 1] = 0xD9;
+        payload = jpeg_payload;
+        payload_size = size;
+    }
+}
+
+static void execute_request(uint8_t request)
+{
+    switch(request)
+    {
+        case REQ_DATA_INIT:
+        {
+            prepare_payload(host_para);
+
+            uint32_t packet = fake_config.max_size_per_packet;
+            // the OD frame is the latest raised event, the motion started a few frames before, one more frame is captured since
+            uint32_t od_frame = frame_counter + FRAME_RING_DEPTH;
+            put_u32(&description[0], (payload_size + packet - 1) / packet);
+            put_u32(&description[4], payload_size);
+            put_u32(&description[8], packet);
+            put_u32(&description[12], od_frame - MOTION_ONSET_FRAMES);  // t1 motion frame
+            put_u32(&description[16], od_frame - FRAME_RING_DEPTH);     // t2 start frame
+            put_u32(&description[20], od_frame + 1);                    // t3 end frame
+            put_u32(&description[24], od_frame + 1);                    // t4 current frame
+            put_u32(&description[28], od_frame);                        // t5 OD frame
+            sram = description;
+            sram_size = DATA_DESCRIPTION_SIZE;
+            sram_offset = 0;
+            break;
+        }
+        case REQ_DATA_REQUEST:
+        {
+            uint32_t length = payload_size - payload_offset;
+            if(length > fake_config.max_size_per_packet)
+                length = fake_config.max_size_per_packet;
+            sram = payload + payload_offset;
+            sram_size = length;
+            sram_offset = 0;
+            payload_offset += length;
+            break;
+        }
+        case REQ_STATE_CLR:
+            into_status &= ~host_para;
+            if(has_pending && (into_status & pending.events) == 0)
+            {
+                has_pending = false;
+                fake_stats.events_cleared++;
+                if(cleared_func != NULL)
+                    cleared_func(&pending, interface_micros());
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static uint8_t fake_read(uint8_t address)
+{
+    transfer_delay();
+    fake_stats.transactions++;
+
+    if(address == BANK_SEL)
+        return bank;
+    if(bank == OD_THRESHOLD_BANK)
+    {
+        if(address >= R_OD_THRESHOLD_BASE && address < R_OD_THRESHOLD_BASE + MAX_OD_SUPPORT_TYPES)
+            return od_thresholds[address - R_OD_THRESHOLD_BASE];
+        return 0;
+    }
+
+    switch(address)
+    {
+        case R_PART_ID_LSB:
+            return PART_ID_LSB_CONST_VAL;
+        case R_PART_ID_MSB:
+            return PART_ID_MSB_CONST_VAL;
+        case R_FW_POWER_ON_READY_0:
+            return power_on_ready ? 0x01 : 0x00;
+        case R_INTO_STATUS:
+            raise_due_events();
+            return into_status;
+        case R_RPT_SRAM_DATA_REG:
+            if(sram == NULL || sram_offset >= sram_size)
+                return 0;
+            fake_stats.sram_bytes++;
+            return sram[sram_offset++];
+        case R_OP_MODE_HOST:
+            return mode;
+        case R_OP_HOST_REQ:
+            return 0;   // every request is handled immediately
+        default:
+            return registers[address & 0x7F];
+    }
+}
+
+static void fake_write(uint8_t address, uint8_t data)
+{
+    transfer_delay();
+    fake_stats.transactions++;
+
+    if(address == BANK_SEL)
+    {
+        bank = data;
+        return;
+    }
+    if(bank == OD_THRESHOLD_BANK)
+    {
+        if(address >= R_OD_THRESHOLD_BASE && address < R_OD_THRESHOLD_BASE + MAX_OD_SUPPORT_TYPES)
+            od_thresholds[address - R_OD_THRESHOLD_BASE] = data;
+        return;
+    }
+
+    switch(address)
+    {
+        case CPU_VALID_CONTROL:
+            cpu_valid = (data & 0x01) != 0;
+            break;
+        case R_CPU_RESET_ENL:
+            if(cpu_valid && (data & 0x01) != 0 && !power_on_ready)
+            {   // firmware boots and reports it is ready
+                power_on_ready = true;
+                into_status |= READY_EVENT;
+            }
+            break;
+        case R_OP_MODE_HOST:
+            mode = data;
+            break;
+        case R_OP_HOST_PARA:
+            host_para = data;
+            break;
+        case R_OP_HOST_PARA0_REG:
+            tindex = (tindex & 0xFF00) | data;
+            break;
+        case R_OP_HOST_PARA1_REG:
+            tindex = (tindex & 0x00FF) | (data << 8);
+            break;
+        case R_OP_HOST_REQ:
+            execute_request(data);
+            break;
+        default:
+            registers[address & 0x7F] = data;
+            break;
+    }
+}
+
+#endif // PLATFORM_HOST_SIM
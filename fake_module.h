@@ -0,0 +1,136 @@
+/** InstAI Co. (Public Version)
+    Description: Scriptable register-level fake AI module serving the driver on a simulated host
+    Modified Date: Oct 19, 2026
+    Remark: requires PLATFORM_HOST_SIM, the fake module emulates the registers, SRAM readout and event handshake
+        used by ai_module.cpp, events are scheduled by the caller and raised when their due time is reached,
+        like the real module a new event cannot be raised until the host cleared the previous one (the new event is lost),
+        the due times and the transfer delays follow interface_micros() and interface_delay_us(), so that the fake module
+        also runs on the virtual clock (see interface_virtual_clock())
+*/
+
+#ifndef FAKE_MODULE_H
+#define FAKE_MODULE_H
+
+#include "ai_module.h"
+
+#ifdef PLATFORM_HOST_SIM
+
+//-- Constant values
+#define FAKE_MODULE_QUEUE_SIZE  256     // scheduled events not raised yet
+// event bits of the interrupt status register
+#define FAKE_MODULE_OD_EVENT    0x02
+#define FAKE_MODULE_JPEG_EVENT  0x40
+
+//-- Structures
+/**
+    @brief: settings of the fake module
+    @remark: call fake_module_default_config() to fill the default values before customizing the settings
+*/
+struct fake_module_config_struct {
+    uint32_t spi_clock_hz;          // emulated SPI clock (each register access costs 16 clocks), 0 = no transfer delay
+    uint32_t max_size_per_packet;   // SRAM readout packet size reported in the data description
+};
+
+/**
+    @brief: an event scheduled on the fake module
+*/
+struct fake_module_event_struct {
+    uint32_t id;                    // given by the caller, written after the SOI marker of the JPEG and followed by
+                                    // the frame index (requested T-index, or the OD frame by default)
+    uint32_t due_us;                // interface_micros() time when the event is raised
+    uint8_t events;                 // FAKE_MODULE_OD_EVENT, optionally with FAKE_MODULE_JPEG_EVENT
+    uint32_t jpeg_size;             // size of the generated JPEG (at most AI_MODULE_BUFFER_SIZE)
+    struct od_data_struct od;       // OD result reported with the event
+};
+
+/**
+    @brief: statistics of the fake module
+*/
+struct fake_module_stats_struct {
+    uint64_t transactions;          // register accesses
+    uint64_t sram_bytes;            // bytes read from the SRAM data register
+    uint64_t events_scheduled;
+    uint64_t events_raised;
+    uint64_t events_cleared;        // events of which every bit has been cleared by the host
+    uint64_t events_lost;           // events due while the previous event was not cleared yet
+    uint32_t queue_high_water;      // maximum number of scheduled events waiting to be raised
+};
+
+//-- Function Pointer
+/**
+    @brief: function pointer which points to custom function called when the host cleared the last bit of an event
+    @parameter:
+        event:  the cleared event
+        now_us: interface_micros() time of the clear
+*/
+typedef void (*FunPtr_FakeModuleEventCleared)(const struct fake_module_event_struct *event, uint32_t now_us);
+
+/**
+    @brief: fill the default settings
+    @parameter:
+        config: give the variable with type "fake_module_config_struct" to store the settings
+    @return:
+        (NONE)
+    @remark: no transfer delay, 4 KB packets
+*/
+void fake_module_default_config(struct fake_module_config_struct *config);
+
+/**
+    @brief: power on the fake module with empty schedule and statistics
+    @parameter:
+        config: settings of the fake module, or NULL to use the default settings
+    @return:
+        simulated device to be passed to interface_spi_init()
+*/
+const struct interface_sim_device *fake_module_init(const struct fake_module_config_struct *config);
+
+/**
+    @brief: register the function called when an event has been cleared
+    @parameter:
+        cleared_func: function with prototype void [Custom_Function_Name](const struct fake_module_event_struct *event, uint32_t now_us);
+    @return:
+        (NONE)
+*/
+void fake_module_register_cleared_func(FunPtr_FakeModuleEventCleared cleared_func);
+
+/**
+    @brief: schedule an event
+    @parameter:
+        event: the event to raise, due times must be given in increasing order
+    @return:
+        return true if the event is scheduled
+        otherwise, return false (FAKE_MODULE_QUEUE_SIZE events are already waiting)
+    @remark: due events are raised when the host reads the interrupt status register
+*/
+bool fake_module_schedule_event(const struct fake_module_event_struct *event);
+
+/**
+    @brief: get the number of scheduled events waiting to be raised
+    @parameter:
+        (NONE)
+    @return:
+        number of scheduled events
+*/
+uint32_t fake_module_scheduled_events();
+
+/**
+    @brief: get the raised event which has not been cleared by the host
+    @parameter:
+        (NONE)
+    @return:
+        the pending event, or NULL if there is none
+*/
+const struct fake_module_event_struct *fake_module_pending_event();
+
+/**
+    @brief: get the statistics of the fake module
+    @parameter:
+        stats: give the variable with type "fake_module_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void fake_module_get_stats(struct fake_module_stats_struct *stats);
+
+#endif // PLATFORM_HOST_SIM
+
+#endif // FAKE_MODULE_H
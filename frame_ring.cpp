@@ -0,0 +1,304 @@
+/** InstAI Co. (Public Version)
+    Description: In-memory ring of the recent JPEGs and OD results, flushing the frames around an incident as a single clip
+    Modified Date: Oct 19, 2026
+*/
+#include "frame_ring.h"
+
+#ifdef PLATFORM_POSIX
+#include <fcntl.h>
+#include <limits.h>
+
+//-- Constant values
+#define MAX_CHUNKS          (1 + 2 * FRAME_RING_MAX_FRAMES)     // clip header, then record and JPEG of each frame
+
+//-- Structures
+// beginning of a clip file
+struct clip_header_struct {
+    char magic[8];
+    uint32_t frame_num;
+};
+
+/* ---- internal function prototypes declaration ---- */
+static bool find_space(const struct frame_ring_struct *ring, uint32_t size, uint32_t *offset);
+static void discard_oldest(struct frame_ring_struct *ring);
+static void update_trigger(struct frame_ring_struct *ring, const struct od_data_struct *od_result);
+static void write_clip(struct frame_ring_struct *ring);
+
+void frame_ring_default_config(struct frame_ring_config_struct *config)
+{
+    memset(config, 0, sizeof(struct frame_ring_config_struct));
+    config->ring_bytes = 2 * 1024 * 1024;
+    config->max_frames = 64;
+    config->pre_roll_frames = 10;
+    config->post_roll_frames = 10;
+    config->trigger_events = 3;
+    config->trigger_type_mask = 0;
+    config->min_confidence = 50;
+}
+
+bool frame_ring_init(struct frame_ring_struct *ring, const struct frame_ring_config_struct *config, FunPtr_FrameRingSink sink_func, void *sink_arg)
+{
+    memset(ring, 0, sizeof(struct frame_ring_struct));
+    if(config != NULL)
+        ring->config = *config;
+    else
+        frame_ring_default_config(&ring->config);
+    if(sink_func == NULL || ring->config.ring_bytes == 0 || ring->config.max_frames == 0
+        || ring->config.max_frames > FRAME_RING_MAX_FRAMES || ring->config.trigger_events == 0)
+        return false;
+
+    ring->data = (uint8_t *)malloc(ring->config.ring_bytes);
+    if(ring->data == NULL)
+        return false;
+    ring->sink_func = sink_func;
+    ring->sink_arg = sink_arg;
+    return true;
+}
+
+static bool find_space(const struct frame_ring_struct *ring, uint32_t size, uint32_t *offset)
+{
+    if(ring->frame_num == 0)
+    {
+        *offset = 0;
+        return true;
+    }
+
+    // the JPEGs are stored contiguously in arrival order, wrapping to the beginning of the ring when the end is reached
+    const struct frame_ring_frame_struct *oldest = &ring->frame[ring->frame_first];
+    const struct frame_ring_frame_struct *newest = &ring->frame[(ring->frame_first + ring->frame_num - 1) % ring->config.max_frames];
+    uint32_t end = newest->offset + newest->record.jpeg_size;
+    if(newest->offset >= oldest->offset)
+    {
+        if(end + size <= ring->config.ring_bytes)
+        {
+            *offset = end;
+            return true;
+        }
+        if(size <= oldest->offset)
+        {
+            *offset = 0;
+            return true;
+        }
+        return false;
+    }
+    if(end + size <= oldest->offset)
+    {
+        *offset = end;
+        return true;
+    }
+    return false;
+}
+
+static void discard_oldest(struct frame_ring_struct *ring)
+{
+    struct frame_ring_frame_struct *oldest = &ring->frame[ring->frame_first];
+    if(ring->is_triggered && oldest->record.sequence - ring->clip.first_sequence < 0x80000000UL)
+        write_clip(ring);   // the clip is about to lose its first frame, write it with the post-roll frames received so far
+    if(!oldest->is_flushed)
+        ring->stats.frames_discarded++;
+    ring->frame_first = (ring->frame_first + 1) % ring->config.max_frames;
+    ring->frame_num--;
+}
+
+static void update_trigger(struct frame_ring_struct *ring, const struct od_data_struct *od_result)
+{
+    bool is_detected[MAX_OD_SUPPORT_TYPES] = { false };
+    uint8_t object_num = 0;
+    if(od_result != NULL)
+        object_num = od_result->object_num < MAX_OD_SUPPORT_OBJECTS ? od_result->object_num : MAX_OD_SUPPORT_OBJECTS;
+    for(uint8_t i = 0; i < object_num; i++)
+    {
+        uint8_t object_type = od_result->object[i].object_type;
+        if(object_type >= OD_OBJECT_TYPE_OFFSET && object_type < OD_OBJECT_TYPE_OFFSET + MAX_OD_SUPPORT_TYPES
+            && od_result->object[i].confidence_level >= ring->config.min_confidence)
+            is_detected[object_type - OD_OBJECT_TYPE_OFFSET] = true;
+    }
+
+    uint8_t trigger_type = 0;
+    for(uint8_t t = 0; t < MAX_OD_SUPPORT_TYPES; t++)
+    {
+        ring->consecutive[t] = is_detected[t] ? ring->consecutive[t] + 1 : 0;
+        if(ring->consecutive[t] >= ring->config.trigger_events && trigger_type == 0
+            && (ring->config.trigger_type_mask == 0 || (ring->config.trigger_type_mask & (1UL << t)) != 0))
+            trigger_type = t + OD_OBJECT_TYPE_OFFSET;
+    }
+    if(trigger_type == 0 || ring->is_triggered)
+        return;
+
+    // the clip starts with the pre-roll frames which have not been written to a clip yet
+    uint16_t index = (ring->frame_first + ring->frame_num - 1) % ring->config.max_frames;
+    uint32_t trigger_sequence = ring->frame[index].record.sequence;
+    uint32_t first_sequence = trigger_sequence;
+    for(uint16_t n = 1; n <= ring->config.pre_roll_frames && n < ring->frame_num; n++)
+    {
+        index = (index + ring->config.max_frames - 1) % ring->config.max_frames;
+        if(ring->frame[index].is_flushed)
+            break;
+        first_sequence = ring->frame[index].record.sequence;
+    }
+
+    ring->is_triggered = true;
+    ring->clip.first_sequence = first_sequence;
+    ring->clip.trigger_sequence = trigger_sequence;
+    ring->clip.trigger_type = trigger_type;
+    ring->post_roll_left = ring->config.post_roll_frames;
+    // holding the object type again for trigger_events OD events starts the next clip
+    memset(ring->consecutive, 0, sizeof(ring->consecutive));
+    if(ring->post_roll_left == 0)
+        write_clip(ring);
+}
+
+bool frame_ring_feed(struct frame_ring_struct *ring, const uint8_t *jpeg_data, uint32_t jpeg_size, const struct od_data_struct *od_result,
+    enum AI_MODULE_JPEG_FRAME jpeg_frame)
+{
+    uint32_t offset;
+
+    if(jpeg_size > ring->config.ring_bytes)
+    {
+        ring->stats.frames_rejected++;
+        return false;
+    }
+    ring->stats.frames++;
+
+    while(ring->frame_num >= ring->config.max_frames || !find_space(ring, jpeg_size, &offset))
+        discard_oldest(ring);
+
+    struct frame_ring_frame_struct *frame = &ring->frame[(ring->frame_first + ring->frame_num) % ring->config.max_frames];
+    frame->offset = offset;
+    frame->is_flushed = false;
+    frame->record.sequence = ring->sequence++;
+    frame->record.capture_us = interface_micros();
+    frame->record.jpeg_size = jpeg_size;
+    if(od_result != NULL)
+        frame->record.od_result = *od_result;
+    else
+        memset(&frame->record.od_result, 0, sizeof(struct od_data_struct));
+    memcpy(&ring->data[offset], jpeg_data, jpeg_size);
+    ring->frame_num++;
+
+    // the selected frames of an event come in chronological order, a frame which is not later than the previous one starts the next event
+    bool is_new_event = jpeg_frame == JPEG_FRAME_DEFAULT || ring->last_jpeg_frame == JPEG_FRAME_DEFAULT || jpeg_frame <= ring->last_jpeg_frame;
+    ring->last_jpeg_frame = jpeg_frame;
+
+    // the consecutive detections keep being counted during the post-roll for the next clip
+    bool is_post_roll = ring->is_triggered;
+    if(is_new_event)
+        update_trigger(ring, od_result);
+    if(is_post_roll && --ring->post_roll_left == 0)
+        write_clip(ring);
+    return true;
+}
+
+static void write_clip(struct frame_ring_struct *ring)
+{
+    struct iovec chunks[MAX_CHUNKS];
+    struct clip_header_struct header;
+    int chunk_num = 1;
+
+    memcpy(header.magic, FRAME_RING_CLIP_MAGIC, sizeof(header.magic));
+    chunks[0].iov_base = &header;
+    chunks[0].iov_len = sizeof(header);
+    ring->clip.frame_num = 0;
+    ring->clip.bytes = sizeof(header);
+    for(uint16_t n = 0; n < ring->frame_num; n++)
+    {
+        struct frame_ring_frame_struct *frame = &ring->frame[(ring->frame_first + n) % ring->config.max_frames];
+        if(frame->is_flushed || frame->record.sequence - ring->clip.first_sequence >= 0x80000000UL)
+            continue;   // before the clip
+        chunks[chunk_num].iov_base = &frame->record;
+        chunks[chunk_num].iov_len = sizeof(struct frame_ring_record_struct);
+        chunks[chunk_num + 1].iov_base = &ring->data[frame->offset];
+        chunks[chunk_num + 1].iov_len = frame->record.jpeg_size;
+        chunk_num += 2;
+        ring->clip.frame_num++;
+        ring->clip.bytes += sizeof(struct frame_ring_record_struct) + frame->record.jpeg_size;
+    }
+    header.frame_num = ring->clip.frame_num;
+    ring->is_triggered = false;
+
+    if(!ring->sink_func(&ring->clip, chunks, chunk_num, ring->sink_arg))
+    {   // the frames may still be written with the pre-roll of the next clip
+        ring->stats.clips_failed++;
+        return;
+    }
+    for(uint16_t n = 0; n < ring->frame_num; n++)
+    {
+        struct frame_ring_frame_struct *frame = &ring->frame[(ring->frame_first + n) % ring->config.max_frames];
+        if(frame->record.sequence - ring->clip.first_sequence < 0x80000000UL)
+            frame->is_flushed = true;
+    }
+    ring->stats.clips++;
+    ring->stats.frames_flushed += ring->clip.frame_num;
+    ring->stats.bytes_flushed += ring->clip.bytes;
+}
+
+void frame_ring_flush(struct frame_ring_struct *ring)
+{
+    if(ring->is_triggered)
+        write_clip(ring);
+}
+
+bool frame_ring_file_sink(const struct frame_ring_clip_struct *clip, const struct iovec *chunks, int chunk_num, void *arg)
+{
+    const char *directory = (const char *)arg;
+    char temp_name[256], file_name[256];
+    struct iovec pending[MAX_CHUNKS];
+
+    if(chunk_num > MAX_CHUNKS)
+        return false;
+    snprintf(temp_name, sizeof(temp_name), "%s/clip_%010lu.tmp", directory, (unsigned long)clip->first_sequence);
+    snprintf(file_name, sizeof(file_name), "%s/clip_%010lu.aiclip", directory, (unsigned long)clip->first_sequence);
+    int fd = open(temp_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+        return false;
+
+    // one sequential write of the whole clip, resumed after partial writes
+    memcpy(pending, chunks, chunk_num * sizeof(struct iovec));
+    int index = 0;
+    bool is_written = true;
+    while(index < chunk_num)
+    {
+        ssize_t written = writev(fd, &pending[index], chunk_num - index < IOV_MAX ? chunk_num - index : IOV_MAX);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            is_written = false;
+            break;
+        }
+        while(index < chunk_num && (size_t)written >= pending[index].iov_len)
+        {
+            written -= pending[index].iov_len;
+            index++;
+        }
+        if(written > 0)
+        {
+            pending[index].iov_base = (uint8_t *)pending[index].iov_base + written;
+            pending[index].iov_len -= written;
+        }
+    }
+    if(is_written && fdatasync(fd) != 0)
+        is_written = false;
+    if(close(fd) != 0)
+        is_written = false;
+    if(!is_written || rename(temp_name, file_name) != 0)
+    {
+        unlink(temp_name);
+        return false;
+    }
+    return true;
+}
+
+void frame_ring_get_stats(const struct frame_ring_struct *ring, struct frame_ring_stats_struct *stats)
+{
+    *stats = ring->stats;
+}
+
+void frame_ring_release(struct frame_ring_struct *ring)
+{
+    free(ring->data);
+    ring->data = NULL;
+    ring->frame_num = 0;
+}
+
+#endif // PLATFORM_POSIX
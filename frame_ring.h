@@ -0,0 +1,204 @@
+/** InstAI Co. (Public Version)
+    Description: In-memory ring of the recent JPEGs and OD results, flushing the frames around an incident as a single clip
+    Modified Date: Oct 19, 2026
+    Remark: requires a POSIX platform, the JPEGs given to the save JPEG function are kept in a bounded RAM ring
+        and only reach the storage when an object type is detected in N consecutive OD events: the pre-roll frames,
+        the triggering frame and the next post-roll frames are then written as one clip by a single vectored write,
+        frames which never qualify are overwritten in RAM without any file system access
+        clip format: "AICLIP01" followed by the number of frames (uint32), then for each frame a frame_ring_record_struct
+        followed by the JPEG data (host byte order)
+*/
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include "ai_module.h"
+
+#ifdef PLATFORM_POSIX
+#include <sys/uio.h>
+
+//-- Constant values
+#define FRAME_RING_MAX_FRAMES   256     // frames kept in the ring
+#define FRAME_RING_CLIP_MAGIC   "AICLIP01"
+
+//-- Structures
+/**
+    @brief: settings of the frame ring
+    @remark: call frame_ring_default_config() to fill the default values before customizing the settings
+*/
+struct frame_ring_config_struct {
+    uint32_t ring_bytes;            // RAM reserved for the JPEGs
+    uint16_t max_frames;            // frames kept in the ring (up to FRAME_RING_MAX_FRAMES)
+    uint16_t pre_roll_frames;       // frames before the triggering frame written to the clip
+    uint16_t post_roll_frames;      // frames after the triggering frame written to the clip
+    uint16_t trigger_events;        // consecutive OD events containing the object type which trigger a clip
+    uint32_t trigger_type_mask;     // bit (object_type - OD_OBJECT_TYPE_OFFSET) set for each object type triggering clips, 0 = every type
+    uint8_t min_confidence;         // minimum confidence level of the triggering objects
+};
+
+/**
+    @brief: header of each frame of a clip
+*/
+struct frame_ring_record_struct {
+    uint32_t sequence;              // number of the frame since the initialization
+    uint32_t capture_us;            // interface_micros() time the frame was received
+    uint32_t jpeg_size;
+    struct od_data_struct od_result;    // object_num is 0 if the frame came without OD result
+};
+
+/**
+    @brief: a frame of the ring
+*/
+struct frame_ring_frame_struct {
+    struct frame_ring_record_struct record;
+    uint32_t offset;                // position of the JPEG in the ring
+    bool is_flushed;                // already written to a clip
+};
+
+/**
+    @brief: description of a clip given to the sink
+*/
+struct frame_ring_clip_struct {
+    uint32_t first_sequence;        // sequence of the first frame of the clip
+    uint32_t trigger_sequence;      // sequence of the triggering frame
+    uint8_t trigger_type;           // object type which triggered the clip
+    uint32_t frame_num;
+    uint64_t bytes;                 // size of the clip
+};
+
+/**
+    @brief: statistics of the frame ring
+*/
+struct frame_ring_stats_struct {
+    uint64_t frames;                // frames received
+    uint64_t frames_rejected;       // frames larger than the ring
+    uint64_t frames_discarded;      // frames overwritten without being written to a clip
+    uint64_t frames_flushed;        // frames written to clips
+    uint64_t clips;                 // clips written
+    uint64_t clips_failed;          // clips the sink could not write
+    uint64_t bytes_flushed;
+};
+
+//-- Function Pointer
+/**
+    @brief: function pointer which points to custom function storing a clip
+    @parameter:
+        clip:       description of the clip
+        chunks:     contents of the clip, to be written in order (e.g. with writev())
+        chunk_num:  number of chunks
+        arg:        argument given to frame_ring_init()
+    @return:
+        return true if the clip is stored
+        otherwise, return false
+*/
+typedef bool (*FunPtr_FrameRingSink)(const struct frame_ring_clip_struct *clip, const struct iovec *chunks, int chunk_num, void *arg);
+
+/**
+    @brief: state of the frame ring
+*/
+struct frame_ring_struct {
+    struct frame_ring_config_struct config;
+    uint8_t *data;                  // ring_bytes of JPEG data
+    struct frame_ring_frame_struct frame[FRAME_RING_MAX_FRAMES];
+    uint16_t frame_first;           // oldest frame
+    uint16_t frame_num;
+    uint32_t sequence;              // sequence of the next frame
+    uint16_t consecutive[MAX_OD_SUPPORT_TYPES];     // consecutive OD events containing each object type
+    enum AI_MODULE_JPEG_FRAME last_jpeg_frame;      // frame of the previous JPEG within its event
+    bool is_triggered;              // the post-roll frames of a clip are being received
+    struct frame_ring_clip_struct clip;
+    uint16_t post_roll_left;
+    FunPtr_FrameRingSink sink_func;
+    void *sink_arg;
+    struct frame_ring_stats_struct stats;
+};
+
+/**
+    @brief: fill the default settings
+    @parameter:
+        config: give the variable with type "frame_ring_config_struct" to store the settings
+    @return:
+        (NONE)
+    @remark: 64 frames in 2 MB, 10 pre-roll and 10 post-roll frames, triggered by any object type
+        detected with 50% confidence in 3 consecutive OD events
+*/
+void frame_ring_default_config(struct frame_ring_config_struct *config);
+
+/**
+    @brief: allocate the ring
+    @parameter:
+        ring:       the frame ring to initialize
+        config:     settings of the ring, or NULL to use the default settings
+        sink_func:  function with prototype bool [Custom_Function_Name](const struct frame_ring_clip_struct *clip,
+                    const struct iovec *chunks, int chunk_num, void *arg); such as frame_ring_file_sink()
+        sink_arg:   argument given to the sink function
+    @return:
+        return true if the ring is allocated
+        otherwise, return false
+*/
+bool frame_ring_init(struct frame_ring_struct *ring, const struct frame_ring_config_struct *config, FunPtr_FrameRingSink sink_func, void *sink_arg);
+
+/**
+    @brief: keep a received JPEG in the ring, and write a clip when its post-roll frames are complete
+    @parameter:
+        ring:       the frame ring
+        jpeg_data:  JPEG data provided by the save JPEG function (copied into the ring)
+        jpeg_size:  size of JPEG data
+        od_result:  OD result of the JPEG, or NULL
+        jpeg_frame: frame of the JPEG given by ai_module_get_jpeg_frame()
+    @return:
+        return true if the frame is kept
+        otherwise, return false (the frame is larger than the ring)
+    @remark: call it from the save JPEG function registered by ai_module_register_save_jpeg_func(),
+        the frames selected by ai_module_set_jpeg_frames() share the OD result of their event which is counted once
+        toward the trigger, a clip whose frames are about to be overwritten is written with fewer post-roll frames
+*/
+bool frame_ring_feed(struct frame_ring_struct *ring, const uint8_t *jpeg_data, uint32_t jpeg_size, const struct od_data_struct *od_result,
+    enum AI_MODULE_JPEG_FRAME jpeg_frame);
+
+/**
+    @brief: write the clip being completed with the post-roll frames received so far
+    @parameter:
+        ring: the frame ring
+    @return:
+        (NONE)
+    @remark: call it before exiting the program
+*/
+void frame_ring_flush(struct frame_ring_struct *ring);
+
+/**
+    @brief: sink writing each clip to a file of a directory
+    @parameter:
+        clip, chunks, chunk_num: given by the frame ring
+        arg: directory of the clips (const char *)
+    @return:
+        return true if the clip file is written
+        otherwise, return false
+    @remark: the clip is written to a temporary file by writev() and synced, then renamed to clip_<first sequence>.aiclip,
+        so a clip file is either complete or absent
+*/
+bool frame_ring_file_sink(const struct frame_ring_clip_struct *clip, const struct iovec *chunks, int chunk_num, void *arg);
+
+/**
+    @brief: get the statistics of the frame ring
+    @parameter:
+        ring:   the frame ring
+        stats:  give the variable with type "frame_ring_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void frame_ring_get_stats(const struct frame_ring_struct *ring, struct frame_ring_stats_struct *stats);
+
+/**
+    @brief: release the ring
+    @parameter:
+        ring: the frame ring
+    @return:
+        (NONE)
+    @remark: call frame_ring_flush() first to write the clip being completed
+*/
+void frame_ring_release(struct frame_ring_struct *ring);
+
+#endif // PLATFORM_POSIX
+
+#endif // FRAME_RING_H
@@ -3,9 +3,25 @@
     Modified Date: Feb 03, 2023
 */
 #include "interface.h"
+#ifdef AI_MODULE_SPI_TRACE
+#include "spi_trace.h"
+#endif
+
+/* ---- internal function prototypes declaration ---- */
+static uint32_t real_time_micros(void *context);
+static void real_time_delay_us(void *context, uint32_t delay_us);
+static uint32_t virtual_micros(void *context);
+static void virtual_delay_us(void *context, uint32_t delay_us);
+
+static const struct interface_clock _real_time_clock = { real_time_micros, real_time_delay_us, NULL };
+static const struct interface_clock _virtual_clock = { virtual_micros, virtual_delay_us, NULL };
+static const struct interface_clock *_clock = &_real_time_clock;
+static uint64_t _virtual_time_us = 0;      // accessed atomically on POSIX, the simulated device may advance it from another thread
 
 #ifdef PLATFORM_ARDUINO
 static SPIClass *_spi = NULL;
+#elif defined PLATFORM_HOST_SIM
+static const struct interface_sim_device *_sim_device = NULL;
 #endif
 
 // initialize SPI Interface with settings SPI Mode = 3, SPI clock speed < 20 MHz
@@ -35,6 +51,15 @@ bool interface_spi_init(SPIClass *spi_class)
     _spi = spi_class;
     return true;
 }
+#elif defined PLATFORM_HOST_SIM
+bool interface_spi_init(const struct interface_sim_device *device)
+{
+    if(device == NULL || device->read == NULL || device->write == NULL)
+        return false;
+
+    _sim_device = device;
+    return true;
+}
 #else   // define your hardware platform here other than Raspberry Pi or Arduino
 
 #endif
@@ -68,10 +93,16 @@ void interface_spi_write(uint8_t pin_cs, uint8_t address, uint8_t data)
         _spi->endTransaction();
         interface_digital_write(pin_cs, HIGH);
     }
+#elif defined PLATFORM_HOST_SIM
+    (void)pin_cs;
+    _sim_device->write(address, data);
 #else   // define your hardware platform here other than Raspberry Pi or Arduino
 
 #endif // PLATFORM_RASPI
     /***/
+#ifdef AI_MODULE_SPI_TRACE
+    spi_trace_record(SPI_TRACE_OP_WRITE, address, data);
+#endif
 }
 
 uint8_t interface_spi_read(uint8_t pin_cs, uint8_t address)
@@ -104,9 +135,94 @@ uint8_t interface_spi_read(uint8_t pin_cs, uint8_t address)
         _spi->endTransaction();
         interface_digital_write(pin_cs, HIGH);
     }
+#elif defined PLATFORM_HOST_SIM
+    (void)pin_cs;
+    val = _sim_device->read(address);
 #else   // define your hardware platform here other than Raspberry Pi or Arduino
 
 #endif // PLATFORM_RASPI
     /***/
+#ifdef AI_MODULE_SPI_TRACE
+    spi_trace_record(SPI_TRACE_OP_READ, address, val);
+#endif
     return val;
 }
+
+void interface_set_clock(const struct interface_clock *clock)
+{
+    _clock = clock != NULL ? clock : &_real_time_clock;
+}
+
+uint32_t interface_micros()
+{
+    return _clock->micros(_clock->context);
+}
+
+void interface_delay_us(uint32_t delay_us)
+{
+    _clock->delay_us(_clock->context, delay_us);
+}
+
+static uint32_t real_time_micros(void *context)
+{
+    (void)context;
+#ifdef PLATFORM_POSIX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#elif defined PLATFORM_ARDUINO
+    return micros();
+#else   // define your hardware platform here other than Raspberry Pi or Arduino
+    return 0;   // return the microsecond counter of your platform
+#endif // PLATFORM_POSIX
+}
+
+static void real_time_delay_us(void *context, uint32_t delay_us)
+{
+    if(delay_us < INTERFACE_BUSY_WAIT_US)
+    {   // sleeping would take longer than the delay
+        uint32_t start_us = real_time_micros(context);
+        while(real_time_micros(context) - start_us < delay_us);
+        return;
+    }
+#ifdef PLATFORM_POSIX
+    usleep(delay_us);
+#elif defined PLATFORM_ARDUINO
+    // delayMicroseconds() is only accurate up to 16383 us
+    delay(delay_us / 1000);
+    delayMicroseconds(delay_us % 1000);
+#else   // define your hardware platform here other than Raspberry Pi or Arduino
+
+#endif // PLATFORM_POSIX
+}
+
+const struct interface_clock *interface_virtual_clock()
+{
+    return &_virtual_clock;
+}
+
+void interface_virtual_clock_advance(uint32_t elapsed_us)
+{
+#ifdef PLATFORM_POSIX
+    __atomic_add_fetch(&_virtual_time_us, elapsed_us, __ATOMIC_RELAXED);
+#else
+    _virtual_time_us += elapsed_us;
+#endif
+}
+
+static uint32_t virtual_micros(void *context)
+{
+    (void)context;
+#ifdef PLATFORM_POSIX
+    return (uint32_t)__atomic_load_n(&_virtual_time_us, __ATOMIC_RELAXED);
+#else
+    return (uint32_t)_virtual_time_us;
+#endif
+}
+
+static void virtual_delay_us(void *context, uint32_t delay_us)
+{
+    (void)context;
+    interface_virtual_clock_advance(delay_us);
+}
+
@@ -10,10 +10,31 @@
 #include <stdint.h>
 #include <unistd.h>
 
+#if !defined PLATFORM_RASPI && !defined PLATFORM_ARDUINO && !defined PLATFORM_HOST_SIM
 // uncomment the following line if your host platform is Raspberry Pi
 //#define PLATFORM_RASPI
 // uncomment the following line if your host platform is Arduino
 #define PLATFORM_ARDUINO
+// uncomment the following line to run the driver on a Linux host against a simulated AI module
+// (e.g. SPI trace replay, see spi_trace.h), no GPIO or SPI hardware is accessed
+//#define PLATFORM_HOST_SIM
+#endif
+
+// uncomment the following line to record every SPI transaction into a binary trace file (see spi_trace.h)
+//#define AI_MODULE_SPI_TRACE
+
+// delays shorter than this are busy-waited by the real-time clock (see interface_delay_us())
+#define INTERFACE_BUSY_WAIT_US  100
+
+// platforms running on top of a POSIX system (file, thread and time APIs are available)
+#if defined PLATFORM_RASPI || defined PLATFORM_HOST_SIM
+    #define PLATFORM_POSIX
+    #include <time.h>
+#endif
+
+#if defined AI_MODULE_SPI_TRACE && !defined PLATFORM_POSIX
+    #error "AI_MODULE_SPI_TRACE requires a POSIX platform to write the trace file"
+#endif
 
 /** include the GPIO library to perform GPIO operations on your platform */
 #ifdef PLATFORM_RASPI
@@ -43,6 +64,27 @@
     #define interface_digital_read(pin)             (digitalRead(pin) & 0x01)
     #define interface_digital_write(pin, level)     digitalWrite(pin, level & 0x01)
 
+#elif defined PLATFORM_HOST_SIM
+    #define HIGH    1
+    #define LOW     0
+
+    // there is no GPIO on the simulated host, pin operations do nothing and inputs always read LOW
+    #define interface_gpio_input(pin)               ((void)(pin))
+    #define interface_gpio_output(pin)              ((void)(pin))
+    #define interface_digital_read(pin)             ((void)(pin), 0)
+    #define interface_digital_write(pin, level)     ((void)(pin), (void)(level))
+
+    /**
+        @brief simulated AI module attached to the host SPI bus
+        @remark every interface_spi_read()/interface_spi_write() is forwarded to the functions below,
+            the address passed to read() is the register address without the read flag (MSB)
+    */
+    struct interface_sim_device
+    {
+        uint8_t (*read)(uint8_t address);
+        void (*write)(uint8_t address, uint8_t data);
+    };
+
 #else   // define your hardware platform here other than Raspberry Pi or Arduino
 
 #endif // PLATFORM_RASPI
@@ -64,11 +106,15 @@
         on Arduino: if you're using Arduino platform, you can either
             pass the initialized SPIClass object pointer, or pass
             NULL to use default SPI object
+        on simulated host: pass the simulated AI module which serves
+            all SPI transactions
 */
 #ifdef PLATFORM_RASPI
 bool interface_spi_init();
 #elif defined PLATFORM_ARDUINO
 bool interface_spi_init(SPIClass *spi_class);
+#elif defined PLATFORM_HOST_SIM
+bool interface_spi_init(const struct interface_sim_device *device);
 #else   // define your hardware platform here other than Raspberry Pi or Arduino
 
 #endif
@@ -94,4 +140,75 @@ void interface_spi_write(uint8_t pin_cs, uint8_t address, uint8_t data);
 */
 uint8_t interface_spi_read(uint8_t pin_cs, uint8_t address);
 
+/**
+    @brief clock used by the driver and the sample code to read the time and to wait
+    @remark
+        every function is given the context of the clock, the real-time clock of the platform
+        is used until another clock is set by interface_set_clock()
+*/
+struct interface_clock
+{
+    uint32_t (*micros)(void *context);
+    void (*delay_us)(void *context, uint32_t delay_us);
+    void *context;
+};
+
+/**
+    @brief set the clock used by interface_micros() and interface_delay_us()
+    @param
+        clock: the clock to use (must stay valid while it is set), or NULL to use the real-time clock of the platform
+    @return
+        (NONE)
+    @remark
+        set the clock before initializing AI module, the real-time polling thread (see rt_loop.h)
+        always waits on the real-time clock
+*/
+void interface_set_clock(const struct interface_clock *clock);
+
+/**
+    @brief get the free running microsecond counter of the host
+    @param
+        (NONE)
+    @return
+        elapsed microseconds since an arbitrary starting point, wraps around every ~71 minutes
+    @remark
+        compare two values by unsigned subtraction so that the wrap around is handled
+*/
+uint32_t interface_micros();
+
+/**
+    @brief wait for the given time
+    @param
+        delay_us: time to wait in microseconds
+    @return
+        (NONE)
+    @remark
+        on the real-time clock, delays shorter than INTERFACE_BUSY_WAIT_US are busy-waited for accuracy,
+        longer ones put the caller to sleep
+*/
+void interface_delay_us(uint32_t delay_us);
+
+/**
+    @brief get the virtual clock, whose time only advances when waiting
+    @param
+        (NONE)
+    @return
+        the virtual clock to be passed to interface_set_clock()
+    @remark
+        with the virtual clock, interface_delay_us() returns immediately after advancing the time,
+        so that a simulated session of hours runs in seconds, the time starts from 0
+*/
+const struct interface_clock *interface_virtual_clock();
+
+/**
+    @brief advance the time of the virtual clock without waiting
+    @param
+        elapsed_us: time to add in microseconds
+    @return
+        (NONE)
+    @remark
+        e.g. to account the processing time of a simulated device
+*/
+void interface_virtual_clock_advance(uint32_t elapsed_us);
+
 #endif  // INTERFACE_H
@@ -0,0 +1,230 @@
+/** InstAI Co. (Public Version)
+    Description: Near-duplicate JPEG detection for the JPEG storage path
+    Modified Date: Oct 19, 2026
+*/
+#include "jpeg_dedup.h"
+
+#ifdef PLATFORM_POSIX
+#include <jpeglib.h>
+#include <setjmp.h>
+
+//-- Constant values
+#define HASH_GRID_SIZE 8    // 8 x 8 cells, one bit per cell
+
+//-- Structure
+// libjpeg reports fatal errors through error_exit(), jump back to the caller instead of exit()
+struct dedup_error_mgr
+{
+    struct jpeg_error_mgr pub;
+    jmp_buf setjmp_buffer;
+};
+
+/* ---- internal function prototypes declaration ---- */
+static void dedup_error_exit(j_common_ptr cinfo);
+static void dedup_output_message(j_common_ptr cinfo);
+static uint8_t hash_distance(uint64_t a, uint64_t b);
+static bool is_similar_size(uint32_t a, uint32_t b, uint8_t percent);
+static bool is_similar_od(const struct jpeg_dedup_config_struct *config, const struct od_data_struct *a, const struct od_data_struct *b);
+
+void jpeg_dedup_default_config(struct jpeg_dedup_config_struct *config)
+{
+    memset(config, 0, sizeof(struct jpeg_dedup_config_struct));
+    config->window_size = 4;
+    config->max_hash_distance = 4;
+    config->max_center_shift = 8;
+    config->max_size_change_percent = 15;
+    config->max_duplicate_run = 300;
+}
+
+void jpeg_dedup_init(struct jpeg_dedup_struct *dedup, const struct jpeg_dedup_config_struct *config)
+{
+    memset(dedup, 0, sizeof(struct jpeg_dedup_struct));
+
+    if(config != NULL)
+        memcpy(&dedup->config, config, sizeof(struct jpeg_dedup_config_struct));
+    else
+        jpeg_dedup_default_config(&dedup->config);
+
+    if(dedup->config.window_size > JPEG_DEDUP_MAX_WINDOW)
+        dedup->config.window_size = JPEG_DEDUP_MAX_WINDOW;
+    if(dedup->config.window_size == 0)
+        dedup->config.window_size = 1;
+}
+
+static void dedup_error_exit(j_common_ptr cinfo)
+{
+    struct dedup_error_mgr *err = (struct dedup_error_mgr *)cinfo->err;
+    longjmp(err->setjmp_buffer, 1);
+}
+
+static void dedup_output_message(j_common_ptr cinfo)
+{   // warnings of corrupted data are reported through the return value only
+    (void)cinfo;
+}
+
+bool jpeg_dedup_hash(const uint8_t *jpeg_data, size_t jpeg_size, uint64_t *hash)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct dedup_error_mgr jerr;
+    int64_t cell_sum[HASH_GRID_SIZE * HASH_GRID_SIZE] = { 0 };
+    uint32_t cell_count[HASH_GRID_SIZE * HASH_GRID_SIZE] = { 0 };
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = dedup_error_exit;
+    jerr.pub.output_message = dedup_output_message;
+    if(setjmp(jerr.setjmp_buffer))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, (unsigned char *)jpeg_data, (unsigned long)jpeg_size);
+    jpeg_read_header(&cinfo, TRUE);
+
+    // entropy decoding only, the DC coefficient of a block is 8 times its average luminance
+    jvirt_barray_ptr *arrays = jpeg_read_coefficients(&cinfo);
+    jpeg_component_info *luma = &cinfo.comp_info[0];
+    JQUANT_TBL *qtable = luma->quant_table != NULL ? luma->quant_table : cinfo.quant_tbl_ptrs[luma->quant_tbl_no];
+    int32_t dc_quant = qtable != NULL ? qtable->quantval[0] : 1;
+
+    for(JDIMENSION by = 0; by < luma->height_in_blocks; by++)
+    {
+        JBLOCKROW row = (*cinfo.mem->access_virt_barray)((j_common_ptr)&cinfo, arrays[0], by, 1, FALSE)[0];
+        uint32_t cell_row = by * HASH_GRID_SIZE / luma->height_in_blocks;
+        for(JDIMENSION bx = 0; bx < luma->width_in_blocks; bx++)
+        {
+            uint32_t cell = cell_row * HASH_GRID_SIZE + bx * HASH_GRID_SIZE / luma->width_in_blocks;
+            cell_sum[cell] += (int32_t)row[bx][0] * dc_quant;
+            cell_count[cell]++;
+        }
+    }
+    jpeg_abort_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    // average hash: one bit per cell, set if the cell is brighter than the frame average
+    int64_t cell_avg[HASH_GRID_SIZE * HASH_GRID_SIZE];
+    int64_t frame_sum = 0;
+    for(uint32_t i = 0; i < HASH_GRID_SIZE * HASH_GRID_SIZE; i++)
+    {
+        cell_avg[i] = cell_count[i] != 0 ? cell_sum[i] / cell_count[i] : 0;
+        frame_sum += cell_avg[i];
+    }
+    int64_t frame_avg = frame_sum / (HASH_GRID_SIZE * HASH_GRID_SIZE);
+
+    *hash = 0;
+    for(uint32_t i = 0; i < HASH_GRID_SIZE * HASH_GRID_SIZE; i++)
+        if(cell_avg[i] > frame_avg)
+            *hash |= (uint64_t)1 << i;
+    return true;
+}
+
+static uint8_t hash_distance(uint64_t a, uint64_t b)
+{
+    return (uint8_t)__builtin_popcountll(a ^ b);
+}
+
+static bool is_similar_size(uint32_t a, uint32_t b, uint8_t percent)
+{
+    uint32_t diff = a > b ? a - b : b - a;
+    uint32_t base = a > b ? a : b;
+    return diff * 100 <= base * percent;
+}
+
+static bool is_similar_od(const struct jpeg_dedup_config_struct *config, const struct od_data_struct *a, const struct od_data_struct *b)
+{
+    if(a == NULL || b == NULL)
+        return a == b;
+    if(a->object_num != b->object_num)
+        return false;
+
+    // every object must have a counterpart of the same type at nearly the same place (object order is not guaranteed)
+    uint32_t used = 0;
+    for(uint8_t i = 0; i < a->object_num && i < MAX_OD_SUPPORT_OBJECTS; i++)
+    {
+        const struct od_object_unit_struct *oa = &a->object[i];
+        bool found = false;
+        for(uint8_t j = 0; j < b->object_num && j < MAX_OD_SUPPORT_OBJECTS; j++)
+        {
+            const struct od_object_unit_struct *ob = &b->object[j];
+            if((used & (1u << j)) || oa->object_type != ob->object_type)
+                continue;
+            uint32_t dx = oa->center_x > ob->center_x ? oa->center_x - ob->center_x : ob->center_x - oa->center_x;
+            uint32_t dy = oa->center_y > ob->center_y ? oa->center_y - ob->center_y : ob->center_y - oa->center_y;
+            if(dx > config->max_center_shift || dy > config->max_center_shift ||
+                !is_similar_size(oa->width, ob->width, config->max_size_change_percent) ||
+                !is_similar_size(oa->height, ob->height, config->max_size_change_percent))
+                continue;
+            used |= 1u << j;
+            found = true;
+            break;
+        }
+        if(!found)
+            return false;
+    }
+    return true;
+}
+
+enum JPEG_DEDUP_RESULT jpeg_dedup_process(struct jpeg_dedup_struct *dedup, const uint8_t *jpeg_data, size_t jpeg_size,
+    const struct od_data_struct *od_result, const char *reference, const char **matched)
+{
+    uint64_t hash = 0;
+
+    dedup->stats.frames++;
+    dedup->stats.bytes_total += jpeg_size;
+    if(matched != NULL)
+        *matched = NULL;
+
+    if(!jpeg_dedup_hash(jpeg_data, jpeg_size, &hash))
+    {
+        dedup->stats.errors++;
+        return JPEG_DEDUP_ERROR;
+    }
+
+    // look for the most similar stored frame, most recent first
+    struct jpeg_dedup_entry_struct *best = NULL;
+    uint8_t best_distance = 0xFF;
+    for(uint8_t i = 0; i < dedup->window_num; i++)
+    {
+        uint8_t index = (dedup->window_next + dedup->config.window_size - 1 - i) % dedup->config.window_size;
+        struct jpeg_dedup_entry_struct *entry = &dedup->window[index];
+        uint8_t distance = hash_distance(hash, entry->hash);
+        if(distance <= dedup->config.max_hash_distance && distance < best_distance &&
+            is_similar_od(&dedup->config, od_result, od_result != NULL ? &entry->od_result : NULL))
+        {
+            best = entry;
+            best_distance = distance;
+        }
+    }
+
+    if(best != NULL && (dedup->config.max_duplicate_run == 0 || best->duplicate_run < dedup->config.max_duplicate_run))
+    {
+        best->duplicate_run++;
+        dedup->stats.duplicates++;
+        dedup->stats.bytes_saved += jpeg_size;
+        if(matched != NULL)
+            *matched = best->reference;
+        return JPEG_DEDUP_DUPLICATE;
+    }
+
+    // keep the unique frame as a reference, the oldest one leaves the window
+    struct jpeg_dedup_entry_struct *entry = &dedup->window[dedup->window_next];
+    memset(entry, 0, sizeof(struct jpeg_dedup_entry_struct));
+    entry->hash = hash;
+    if(od_result != NULL)
+        memcpy(&entry->od_result, od_result, sizeof(struct od_data_struct));
+    if(reference != NULL)
+        strncpy(entry->reference, reference, JPEG_DEDUP_REFERENCE_SIZE - 1);
+
+    dedup->window_next = (dedup->window_next + 1) % dedup->config.window_size;
+    if(dedup->window_num < dedup->config.window_size)
+        dedup->window_num++;
+    return JPEG_DEDUP_UNIQUE;
+}
+
+void jpeg_dedup_get_stats(const struct jpeg_dedup_struct *dedup, struct jpeg_dedup_stats_struct *stats)
+{
+    memcpy(stats, &dedup->stats, sizeof(struct jpeg_dedup_stats_struct));
+}
+
+#endif // PLATFORM_POSIX
@@ -0,0 +1,134 @@
+/** InstAI Co. (Public Version)
+    Description: Near-duplicate JPEG detection for the JPEG storage path
+    Modified Date: Oct 19, 2026
+    Remark: requires a POSIX platform and libjpeg-turbo (link with -ljpeg),
+        a 64-bit perceptual hash is computed from the DC coefficients of the luminance blocks,
+        which only needs entropy decoding (no IDCT), and is combined with the OD bounding boxes
+*/
+
+#ifndef JPEG_DEDUP_H
+#define JPEG_DEDUP_H
+
+#include "ai_module.h"
+
+#ifdef PLATFORM_POSIX
+
+//-- Constant values
+#define JPEG_DEDUP_MAX_WINDOW       16
+#define JPEG_DEDUP_REFERENCE_SIZE   64
+
+//-- Enumerations
+/**
+    @brief: result of jpeg_dedup_process()
+*/
+enum JPEG_DEDUP_RESULT
+{
+    JPEG_DEDUP_UNIQUE = 0,      // store the JPEG, it is kept in the window as a reference for the next frames
+    JPEG_DEDUP_DUPLICATE,       // store the reference only, the JPEG is nearly identical to a stored one
+    JPEG_DEDUP_ERROR            // the JPEG cannot be decoded, store it as is
+};
+
+//-- Structures
+/**
+    @brief: thresholds of the near-duplicate detection
+    @remark: call jpeg_dedup_default_config() to fill the recommended values before customizing the settings
+*/
+struct jpeg_dedup_config_struct {
+    uint8_t window_size;            // number of recently stored frames compared with (up to JPEG_DEDUP_MAX_WINDOW)
+    uint8_t max_hash_distance;      // maximum number of different hash bits (0 ~ 64) of a duplicate
+    uint16_t max_center_shift;      // maximum shift in pixels of each object center (AI module frame coordinates)
+    uint8_t max_size_change_percent;    // maximum change of each object width/height
+    uint16_t max_duplicate_run;     // store a frame anyway after this number of consecutive duplicates of the same reference, 0 = never
+};
+
+/**
+    @brief: recently stored frame
+*/
+struct jpeg_dedup_entry_struct {
+    uint64_t hash;
+    uint16_t duplicate_run;
+    struct od_data_struct od_result;
+    char reference[JPEG_DEDUP_REFERENCE_SIZE];
+};
+
+/**
+    @brief: statistics of the near-duplicate detection
+*/
+struct jpeg_dedup_stats_struct {
+    uint32_t frames;
+    uint32_t duplicates;
+    uint32_t errors;
+    uint64_t bytes_total;           // size of all processed JPEGs
+    uint64_t bytes_saved;           // size of the JPEGs which have been replaced by a reference
+};
+
+/**
+    @brief: state of the near-duplicate detection
+*/
+struct jpeg_dedup_struct {
+    struct jpeg_dedup_config_struct config;
+    struct jpeg_dedup_entry_struct window[JPEG_DEDUP_MAX_WINDOW];
+    uint8_t window_num;
+    uint8_t window_next;
+    struct jpeg_dedup_stats_struct stats;
+};
+
+/**
+    @brief: fill the recommended thresholds
+    @parameter:
+        config: give the variable with type "jpeg_dedup_config_struct" to store the settings
+    @return:
+        (NONE)
+*/
+void jpeg_dedup_default_config(struct jpeg_dedup_config_struct *config);
+
+/**
+    @brief: initialize the near-duplicate detection
+    @parameter:
+        dedup:  the state to initialize
+        config: thresholds, or NULL to use the recommended settings
+    @return:
+        (NONE)
+*/
+void jpeg_dedup_init(struct jpeg_dedup_struct *dedup, const struct jpeg_dedup_config_struct *config);
+
+/**
+    @brief: compute the perceptual hash of a JPEG from the DC coefficients of its luminance blocks
+    @parameter:
+        jpeg_data:  JPEG data
+        jpeg_size:  size of JPEG data
+        hash:       give the variable to store the 64-bit hash
+    @return:
+        return true if the hash is computed
+        otherwise, return false (corrupted JPEG)
+*/
+bool jpeg_dedup_hash(const uint8_t *jpeg_data, size_t jpeg_size, uint64_t *hash);
+
+/**
+    @brief: check whether a received JPEG is a near-duplicate of a recently stored one
+    @parameter:
+        dedup:          the near-duplicate detection state
+        jpeg_data:      JPEG data provided by the save JPEG function
+        jpeg_size:      size of JPEG data
+        od_result:      OD result of the JPEG, or NULL
+        reference:      name under which the JPEG would be stored (e.g. file name), kept for unique frames
+        matched:        returns the reference of the stored frame if the JPEG is a duplicate, can be NULL
+    @return:
+        one of the results defined in enumeration JPEG_DEDUP_RESULT
+*/
+enum JPEG_DEDUP_RESULT jpeg_dedup_process(struct jpeg_dedup_struct *dedup, const uint8_t *jpeg_data, size_t jpeg_size,
+    const struct od_data_struct *od_result, const char *reference, const char **matched);
+
+/**
+    @brief: get the statistics of the near-duplicate detection
+    @parameter:
+        dedup:  the near-duplicate detection state
+        stats:  give the variable with type "jpeg_dedup_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void jpeg_dedup_get_stats(const struct jpeg_dedup_struct *dedup, struct jpeg_dedup_stats_struct *stats);
+
+#endif // PLATFORM_POSIX
+
+#endif // JPEG_DEDUP_H
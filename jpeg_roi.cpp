@@ -0,0 +1,535 @@
+/** InstAI Co. (Public Version)
+    Description: Per-object region-of-interest crops from the JPEG received from AI module
+    Modified Date: Oct 19, 2026
+*/
+#include "jpeg_roi.h"
+
+#ifdef PLATFORM_POSIX
+#include <jpeglib.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <jerror.h>
+
+//-- Constant values
+#define DESTINATION_INITIAL_SIZE 8192   // first allocation of a lossless crop, doubled when full
+
+//-- Structure
+// libjpeg reports fatal errors through error_exit(), jump back to the caller instead of exit()
+struct roi_error_mgr
+{
+    struct jpeg_error_mgr pub;
+    jmp_buf setjmp_buffer;
+};
+
+// growing memory destination whose buffer stays reachable after an error, unlike jpeg_mem_dest()
+struct roi_destination_mgr
+{
+    struct jpeg_destination_mgr pub;
+    uint8_t *data;
+    size_t data_size;       // allocated bytes
+};
+
+// entropy decoded frame shared by the lossless crops of a batch
+struct roi_coefficients_struct
+{
+    struct jpeg_decompress_struct *src;
+    JBLOCKROW *rows[MAX_COMPONENTS];    // block row pointers of each component, read-only for the workers
+};
+
+struct roi_job_struct
+{
+    const uint8_t *jpeg_data;
+    size_t jpeg_size;
+    const struct od_object_unit_struct *object;
+    const struct jpeg_roi_config_struct *config;
+    const struct roi_coefficients_struct *coefficients;    // NULL for RGB output
+    struct jpeg_roi_crop_struct *crop;
+};
+
+/* ---- internal function prototypes declaration ---- */
+static void roi_error_exit(j_common_ptr cinfo);
+static void roi_output_message(j_common_ptr cinfo);
+static void roi_init_destination(j_compress_ptr cinfo);
+static boolean roi_empty_output_buffer(j_compress_ptr cinfo);
+static void roi_term_destination(j_compress_ptr cinfo);
+static bool get_object_region(const struct od_object_unit_struct *object, uint8_t margin_percent,
+    uint32_t image_width, uint32_t image_height, uint32_t *x0, uint32_t *y0, uint32_t *x1, uint32_t *y1);
+static bool crop_lossless(const struct roi_coefficients_struct *coefficients, const struct od_object_unit_struct *object,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crop);
+static bool crop_rgb(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_object_unit_struct *object,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crop);
+static bool read_coefficients(const uint8_t *jpeg_data, size_t jpeg_size, struct jpeg_decompress_struct *src,
+    struct roi_error_mgr *jerr, struct roi_coefficients_struct *coefficients);
+static void release_coefficients(struct jpeg_decompress_struct *src, struct roi_coefficients_struct *coefficients);
+static void run_job(struct roi_job_struct *job);
+static void run_jobs(struct roi_job_struct *jobs, uint8_t job_num);
+static void *worker_main(void *arg);
+
+//-- Global variables
+static pthread_t workers[JPEG_ROI_MAX_WORKERS];
+static uint8_t worker_num = 0;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;     // one batch at a time
+static pthread_cond_t pool_start_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done_cond = PTHREAD_COND_INITIALIZER;
+static struct roi_job_struct *pool_jobs = NULL;
+static uint8_t pool_job_num = 0, pool_next_job = 0, pool_done_jobs = 0;
+static bool pool_stop = false;
+
+bool jpeg_roi_init(uint8_t worker_threads)
+{
+    jpeg_roi_deinit();
+
+    if(worker_threads > JPEG_ROI_MAX_WORKERS)
+        worker_threads = JPEG_ROI_MAX_WORKERS;
+
+    pool_stop = false;
+    for(worker_num = 0; worker_num < worker_threads; worker_num++)
+    {
+        if(pthread_create(&workers[worker_num], NULL, worker_main, NULL) != 0)
+        {
+            jpeg_roi_deinit();
+            return false;
+        }
+    }
+    return true;
+}
+
+void jpeg_roi_deinit()
+{
+    pthread_mutex_lock(&pool_mutex);
+    pool_stop = true;
+    pthread_cond_broadcast(&pool_start_cond);
+    pthread_mutex_unlock(&pool_mutex);
+
+    for(uint8_t i = 0; i < worker_num; i++)
+        pthread_join(workers[i], NULL);
+    worker_num = 0;
+}
+
+bool jpeg_roi_crop_object(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_object_unit_struct *object,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crop)
+{
+    memset(crop, 0, sizeof(struct jpeg_roi_crop_struct));
+    crop->output = config->output;
+
+    if(config->output == JPEG_ROI_OUTPUT_RGB)
+        return crop->valid = crop_rgb(jpeg_data, jpeg_size, object, config, crop);
+
+    struct jpeg_decompress_struct src;
+    struct roi_error_mgr jerr;
+    struct roi_coefficients_struct coefficients;
+
+    if(!read_coefficients(jpeg_data, jpeg_size, &src, &jerr, &coefficients))
+        return false;
+    crop->valid = crop_lossless(&coefficients, object, config, crop);
+    release_coefficients(&src, &coefficients);
+    return crop->valid;
+}
+
+uint8_t jpeg_roi_crop_objects(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_data_struct *od_result,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crops)
+{
+    struct roi_job_struct jobs[MAX_OD_SUPPORT_OBJECTS];
+    struct jpeg_decompress_struct src;
+    struct roi_error_mgr jerr;
+    struct roi_coefficients_struct coefficients;
+    uint8_t object_num = od_result->object_num, valid_num = 0;
+
+    if(object_num > MAX_OD_SUPPORT_OBJECTS)
+        object_num = MAX_OD_SUPPORT_OBJECTS;
+
+    for(uint8_t i = 0; i < object_num; i++)
+    {
+        memset(&crops[i], 0, sizeof(struct jpeg_roi_crop_struct));
+        crops[i].object_index = i;
+        crops[i].output = config->output;
+    }
+    if(object_num == 0)
+        return 0;
+
+    // lossless crops share a single entropy decoding of the frame
+    if(config->output == JPEG_ROI_OUTPUT_JPEG && !read_coefficients(jpeg_data, jpeg_size, &src, &jerr, &coefficients))
+        return 0;
+
+    for(uint8_t i = 0; i < object_num; i++)
+    {
+        jobs[i].jpeg_data = jpeg_data;
+        jobs[i].jpeg_size = jpeg_size;
+        jobs[i].object = &od_result->object[i];
+        jobs[i].config = config;
+        jobs[i].coefficients = config->output == JPEG_ROI_OUTPUT_JPEG ? &coefficients : NULL;
+        jobs[i].crop = &crops[i];
+    }
+    run_jobs(jobs, object_num);
+
+    if(config->output == JPEG_ROI_OUTPUT_JPEG)
+        release_coefficients(&src, &coefficients);
+
+    for(uint8_t i = 0; i < object_num; i++)
+        if(crops[i].valid)
+            valid_num++;
+    return valid_num;
+}
+
+void jpeg_roi_release(struct jpeg_roi_crop_struct *crops, uint8_t crop_num)
+{
+    for(uint8_t i = 0; i < crop_num; i++)
+    {
+        if(crops[i].data != NULL)
+            free(crops[i].data);
+        crops[i].data = NULL;
+        crops[i].size = 0;
+        crops[i].valid = false;
+    }
+}
+
+static void roi_error_exit(j_common_ptr cinfo)
+{
+    struct roi_error_mgr *err = (struct roi_error_mgr *)cinfo->err;
+    longjmp(err->setjmp_buffer, 1);
+}
+
+static void roi_output_message(j_common_ptr cinfo)
+{   // warnings of corrupted data are reported through the return value only
+    (void)cinfo;
+}
+
+static void roi_init_destination(j_compress_ptr cinfo)
+{
+    struct roi_destination_mgr *dest = (struct roi_destination_mgr *)cinfo->dest;
+    dest->data = (uint8_t *)malloc(DESTINATION_INITIAL_SIZE);
+    if(dest->data == NULL)
+        ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 0);
+    dest->data_size = DESTINATION_INITIAL_SIZE;
+    dest->pub.next_output_byte = dest->data;
+    dest->pub.free_in_buffer = dest->data_size;
+}
+
+static boolean roi_empty_output_buffer(j_compress_ptr cinfo)
+{
+    struct roi_destination_mgr *dest = (struct roi_destination_mgr *)cinfo->dest;
+    uint8_t *data = (uint8_t *)realloc(dest->data, dest->data_size * 2);
+    if(data == NULL)
+        ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 0);    // dest->data is still valid and released by the caller
+    dest->data = data;
+    dest->pub.next_output_byte = data + dest->data_size;
+    dest->pub.free_in_buffer = dest->data_size;
+    dest->data_size *= 2;
+    return TRUE;
+}
+
+static void roi_term_destination(j_compress_ptr cinfo)
+{
+    (void)cinfo;    // the size of the crop is data_size - free_in_buffer
+}
+
+static bool get_object_region(const struct od_object_unit_struct *object, uint8_t margin_percent,
+    uint32_t image_width, uint32_t image_height, uint32_t *x0, uint32_t *y0, uint32_t *x1, uint32_t *y1)
+{
+    // OD coordinates are relative to the AI module frame, the JPEG may have a different resolution
+    int64_t half_w = (int64_t)object->width * (100 + 2 * margin_percent) / 200;
+    int64_t half_h = (int64_t)object->height * (100 + 2 * margin_percent) / 200;
+    int64_t left = ((int64_t)object->center_x - half_w) * image_width / AI_MODULE_FRAME_WIDTH;
+    int64_t right = ((int64_t)object->center_x + half_w) * image_width / AI_MODULE_FRAME_WIDTH;
+    int64_t top = ((int64_t)object->center_y - half_h) * image_height / AI_MODULE_FRAME_HEIGHT;
+    int64_t bottom = ((int64_t)object->center_y + half_h) * image_height / AI_MODULE_FRAME_HEIGHT;
+
+    if(left < 0)
+        left = 0;
+    if(top < 0)
+        top = 0;
+    if(right > image_width)
+        right = image_width;
+    if(bottom > image_height)
+        bottom = image_height;
+    if(right <= left || bottom <= top)
+        return false;
+
+    *x0 = (uint32_t)left;
+    *y0 = (uint32_t)top;
+    *x1 = (uint32_t)right;
+    *y1 = (uint32_t)bottom;
+    return true;
+}
+
+static bool read_coefficients(const uint8_t *jpeg_data, size_t jpeg_size, struct jpeg_decompress_struct *src,
+    struct roi_error_mgr *jerr, struct roi_coefficients_struct *coefficients)
+{
+    memset(coefficients, 0, sizeof(struct roi_coefficients_struct));
+    src->err = jpeg_std_error(&jerr->pub);
+    jerr->pub.error_exit = roi_error_exit;
+    jerr->pub.output_message = roi_output_message;
+    if(setjmp(jerr->setjmp_buffer))
+    {
+        release_coefficients(src, coefficients);
+        return false;
+    }
+
+    jpeg_create_decompress(src);
+    coefficients->src = src;
+    jpeg_mem_src(src, (unsigned char *)jpeg_data, (unsigned long)jpeg_size);
+    jpeg_read_header(src, TRUE);
+    jvirt_barray_ptr *arrays = jpeg_read_coefficients(src);
+
+    // resolve the block rows once, the virtual arrays are fully in memory after jpeg_read_coefficients()
+    for(int c = 0; c < src->num_components; c++)
+    {
+        jpeg_component_info *comp = &src->comp_info[c];
+        JDIMENSION row_num = (comp->height_in_blocks + comp->v_samp_factor - 1) / comp->v_samp_factor * comp->v_samp_factor;
+
+        coefficients->rows[c] = (JBLOCKROW *)malloc(row_num * sizeof(JBLOCKROW));
+        if(coefficients->rows[c] == NULL)
+            longjmp(jerr->setjmp_buffer, 1);
+        for(JDIMENSION r = 0; r < row_num; r++)
+            coefficients->rows[c][r] = (*src->mem->access_virt_barray)((j_common_ptr)src, arrays[c], r, 1, FALSE)[0];
+    }
+    return true;
+}
+
+static void release_coefficients(struct jpeg_decompress_struct *src, struct roi_coefficients_struct *coefficients)
+{
+    for(int c = 0; c < MAX_COMPONENTS; c++)
+    {
+        if(coefficients->rows[c] != NULL)
+            free(coefficients->rows[c]);
+        coefficients->rows[c] = NULL;
+    }
+    if(coefficients->src != NULL)
+        jpeg_destroy_decompress(src);
+    coefficients->src = NULL;
+}
+
+static bool crop_lossless(const struct roi_coefficients_struct *coefficients, const struct od_object_unit_struct *object,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crop)
+{
+    struct jpeg_decompress_struct *src = coefficients->src;
+    struct jpeg_compress_struct dst;
+    struct roi_error_mgr jerr;
+    struct roi_destination_mgr dest;    // address given to libjpeg, its buffer is read back after longjmp()
+    jvirt_barray_ptr dst_arrays[MAX_COMPONENTS];
+    uint32_t x0, y0, x1, y1;
+
+    if(!get_object_region(object, config->margin_percent, src->image_width, src->image_height, &x0, &y0, &x1, &y1))
+        return false;
+
+    // the crop must start on the iMCU grid so that DCT blocks can be copied without re-encoding,
+    // the right/bottom edges are free since the decoder discards the padding of partial iMCUs
+    uint32_t imcu_width = src->max_h_samp_factor * DCTSIZE;
+    uint32_t imcu_height = src->max_v_samp_factor * DCTSIZE;
+    x0 = x0 / imcu_width * imcu_width;
+    y0 = y0 / imcu_height * imcu_height;
+    uint32_t imcu_cols = (x1 - x0 + imcu_width - 1) / imcu_width;
+    uint32_t imcu_rows = (y1 - y0 + imcu_height - 1) / imcu_height;
+
+    memset(&dest, 0, sizeof(dest));
+    dest.pub.init_destination = roi_init_destination;
+    dest.pub.empty_output_buffer = roi_empty_output_buffer;
+    dest.pub.term_destination = roi_term_destination;
+    dst.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = roi_error_exit;
+    jerr.pub.output_message = roi_output_message;
+    if(setjmp(jerr.setjmp_buffer))
+    {
+        jpeg_destroy_compress(&dst);
+        if(dest.data != NULL)
+            free(dest.data);
+        return false;
+    }
+
+    jpeg_create_compress(&dst);
+    dst.dest = &dest.pub;
+    jpeg_copy_critical_parameters(src, &dst);
+    dst.image_width = x1 - x0;
+    dst.image_height = y1 - y0;
+
+    for(int c = 0; c < src->num_components; c++)
+    {
+        jpeg_component_info *comp = &src->comp_info[c];
+        dst_arrays[c] = (*dst.mem->request_virt_barray)((j_common_ptr)&dst, JPOOL_IMAGE, FALSE,
+            imcu_cols * comp->h_samp_factor, imcu_rows * comp->v_samp_factor, comp->v_samp_factor);
+    }
+    // realizes the destination arrays and writes the headers, the scan is written by jpeg_finish_compress()
+    jpeg_write_coefficients(&dst, dst_arrays);
+
+    for(int c = 0; c < src->num_components; c++)
+    {
+        jpeg_component_info *comp = &src->comp_info[c];
+        JDIMENSION x_blocks = x0 / imcu_width * comp->h_samp_factor;
+        JDIMENSION y_blocks = y0 / imcu_height * comp->v_samp_factor;
+        JDIMENSION width_blocks = imcu_cols * comp->h_samp_factor;
+
+        for(JDIMENSION r = 0; r < imcu_rows * comp->v_samp_factor; r++)
+        {
+            JBLOCKROW dst_row = (*dst.mem->access_virt_barray)((j_common_ptr)&dst, dst_arrays[c], r, 1, TRUE)[0];
+            memcpy(dst_row, coefficients->rows[c][y_blocks + r] + x_blocks, width_blocks * sizeof(JBLOCK));
+        }
+    }
+
+    jpeg_finish_compress(&dst);
+    jpeg_destroy_compress(&dst);
+
+    crop->x = x0;
+    crop->y = y0;
+    crop->width = x1 - x0;
+    crop->height = y1 - y0;
+    crop->scale_denom = 1;
+    crop->data = dest.data;
+    crop->size = dest.data_size - dest.pub.free_in_buffer;
+    return true;
+}
+
+static bool crop_rgb(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_object_unit_struct *object,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crop)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct roi_error_mgr jerr;
+    uint8_t * volatile out_data = NULL;     // volatile, assigned after setjmp()
+    JSAMPLE * volatile row = NULL;
+    uint32_t x0, y0, x1, y1;
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = roi_error_exit;
+    jerr.pub.output_message = roi_output_message;
+    if(setjmp(jerr.setjmp_buffer))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        if(out_data != NULL)
+            free(out_data);
+        if(row != NULL)
+            free(row);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, (unsigned char *)jpeg_data, (unsigned long)jpeg_size);
+    jpeg_read_header(&cinfo, TRUE);
+
+    if(!get_object_region(object, config->margin_percent, cinfo.image_width, cinfo.image_height, &x0, &y0, &x1, &y1))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    // DCT-domain scaling: the IDCT directly produces the reduced size, no full-size pixels are computed
+    uint32_t side = (x1 - x0) > (y1 - y0) ? (x1 - x0) : (y1 - y0);
+    uint8_t denom = 1;
+    while(config->max_rgb_side != 0 && denom < 8 && (side + denom - 1) / denom > config->max_rgb_side)
+        denom <<= 1;
+
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = denom;
+    cinfo.dct_method = JDCT_ISLOW;
+    jpeg_start_decompress(&cinfo);
+
+    JDIMENSION sx0 = x0 / denom, sy0 = y0 / denom;
+    JDIMENSION sx1 = (x1 + denom - 1) / denom, sy1 = (y1 + denom - 1) / denom;
+    if(sx1 > cinfo.output_width)
+        sx1 = cinfo.output_width;
+    if(sy1 > cinfo.output_height)
+        sy1 = cinfo.output_height;
+
+    // only decode the iMCU columns covering the object (xoffset/width are widened to the iMCU grid)
+    JDIMENSION crop_x = sx0, crop_width = sx1 - sx0;
+    jpeg_crop_scanline(&cinfo, &crop_x, &crop_width);
+
+    uint32_t out_width = sx1 - sx0, out_height = sy1 - sy0;
+    uint32_t out_stride = out_width * 3;
+    out_data = (uint8_t *)malloc((size_t)out_stride * out_height);
+    row = (JSAMPLE *)malloc((size_t)crop_width * cinfo.output_components);
+    if(out_data == NULL || row == NULL)
+        longjmp(jerr.setjmp_buffer, 1);
+
+    // rows above the object are skipped without IDCT/color conversion
+    if(sy0 > 0)
+        jpeg_skip_scanlines(&cinfo, sy0);
+    for(uint32_t y = 0; y < out_height; y++)
+    {
+        JSAMPROW rows[1] = { row };
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        memcpy(&out_data[y * out_stride], &rows[0][(sx0 - crop_x) * 3], out_stride);
+    }
+
+    // rows below the object are never decoded
+    jpeg_abort_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    free(row);
+
+    crop->x = x0;
+    crop->y = y0;
+    crop->width = out_width;
+    crop->height = out_height;
+    crop->scale_denom = denom;
+    crop->data = out_data;
+    crop->size = (size_t)out_stride * out_height;
+    return true;
+}
+
+static void run_job(struct roi_job_struct *job)
+{
+    if(job->coefficients != NULL)
+        job->crop->valid = crop_lossless(job->coefficients, job->object, job->config, job->crop);
+    else
+        job->crop->valid = crop_rgb(job->jpeg_data, job->jpeg_size, job->object, job->config, job->crop);
+}
+
+static void run_jobs(struct roi_job_struct *jobs, uint8_t job_num)
+{
+    if(worker_num == 0 || job_num == 1)
+    {
+        for(uint8_t i = 0; i < job_num; i++)
+            run_job(&jobs[i]);
+        return;
+    }
+
+    pthread_mutex_lock(&batch_mutex);
+    pthread_mutex_lock(&pool_mutex);
+    pool_jobs = jobs;
+    pool_job_num = job_num;
+    pool_next_job = 0;
+    pool_done_jobs = 0;
+    pthread_cond_broadcast(&pool_start_cond);
+
+    // the calling thread takes jobs as well
+    while(pool_next_job < pool_job_num)
+    {
+        uint8_t i = pool_next_job++;
+        pthread_mutex_unlock(&pool_mutex);
+        run_job(&pool_jobs[i]);
+        pthread_mutex_lock(&pool_mutex);
+        pool_done_jobs++;
+    }
+    while(pool_done_jobs < pool_job_num)
+        pthread_cond_wait(&pool_done_cond, &pool_mutex);
+
+    pool_jobs = NULL;
+    pool_job_num = 0;
+    pool_next_job = 0;
+    pthread_mutex_unlock(&pool_mutex);
+    pthread_mutex_unlock(&batch_mutex);
+}
+
+static void *worker_main(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&pool_mutex);
+    while(1)
+    {
+        while(!pool_stop && pool_next_job >= pool_job_num)
+            pthread_cond_wait(&pool_start_cond, &pool_mutex);
+        if(pool_stop)
+            break;
+
+        uint8_t i = pool_next_job++;
+        pthread_mutex_unlock(&pool_mutex);
+        run_job(&pool_jobs[i]);
+        pthread_mutex_lock(&pool_mutex);
+        if(++pool_done_jobs == pool_job_num)
+            pthread_cond_signal(&pool_done_cond);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+    return NULL;
+}
+
+#endif // PLATFORM_POSIX
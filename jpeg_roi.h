@@ -0,0 +1,120 @@
+/** InstAI Co. (Public Version)
+    Description: Per-object region-of-interest crops from the JPEG received from AI module
+    Modified Date: Oct 19, 2026
+    Remark: requires a POSIX platform and libjpeg-turbo (link with -ljpeg -lpthread),
+        the full frame is never decoded:
+            JPEG_ROI_OUTPUT_JPEG: lossless crop in DCT domain, only entropy decoding/encoding is performed
+            JPEG_ROI_OUTPUT_RGB:  partial decoding of the iMCU columns/rows covering the object, with DCT-domain down-scaling
+*/
+
+#ifndef JPEG_ROI_H
+#define JPEG_ROI_H
+
+#include "ai_module.h"
+
+#ifdef PLATFORM_POSIX
+
+//-- Constant values
+#define JPEG_ROI_MAX_WORKERS 8
+
+//-- Enumerations
+/**
+    @brief: format of the produced crops
+*/
+enum JPEG_ROI_OUTPUT
+{
+    JPEG_ROI_OUTPUT_JPEG = 0,   // JPEG file, crop origin aligned to the iMCU grid (8 or 16 pixels), bit-exact with the source
+    JPEG_ROI_OUTPUT_RGB         // packed RGB888 pixels, 3 * width bytes per row
+};
+
+//-- Structures
+/**
+    @brief: settings of the crop operation
+*/
+struct jpeg_roi_config_struct {
+    enum JPEG_ROI_OUTPUT output;
+    uint8_t margin_percent;     // enlarge each side of the bounding box by this percentage of its size
+    uint16_t max_rgb_side;      // JPEG_ROI_OUTPUT_RGB only: scale down by 1/2, 1/4 or 1/8 until the longer side fits, 0 keeps full size
+};
+
+/**
+    @brief: crop of one detected object
+    @remark: x, y, width and height are given in JPEG pixel coordinates, width and height of an RGB crop
+        are the scaled size (scale_denom > 1)
+*/
+struct jpeg_roi_crop_struct {
+    bool valid;
+    uint8_t object_index;       // index of the object in od_data_struct
+    uint8_t scale_denom;        // 1, 2, 4 or 8
+    enum JPEG_ROI_OUTPUT output;
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    uint8_t *data;              // release with jpeg_roi_release()
+    size_t size;
+};
+
+/**
+    @brief: start the worker threads used by jpeg_roi_crop_objects()
+    @parameter:
+        worker_num: number of worker threads (up to JPEG_ROI_MAX_WORKERS), 0 crops in the calling thread only
+    @return:
+        return true if the worker threads are started successfully
+        otherwise, return false
+*/
+bool jpeg_roi_init(uint8_t worker_num);
+
+/**
+    @brief: stop the worker threads
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+*/
+void jpeg_roi_deinit();
+
+/**
+    @brief: crop a single object from the JPEG
+    @parameter:
+        jpeg_data:  JPEG data provided by the save JPEG function
+        jpeg_size:  size of JPEG data
+        object:     detected object attributes (coordinates relative to AI_MODULE_FRAME_WIDTH x AI_MODULE_FRAME_HEIGHT)
+        config:     settings of the crop operation
+        crop:       give the variable with type "jpeg_roi_crop_struct" to store the crop
+    @return:
+        return true if the crop is produced
+        otherwise, return false (corrupted JPEG or empty region)
+*/
+bool jpeg_roi_crop_object(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_object_unit_struct *object,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crop);
+
+/**
+    @brief: crop every object of the OD result from the JPEG, the crops are distributed over the worker threads
+    @parameter:
+        jpeg_data:  JPEG data provided by the save JPEG function
+        jpeg_size:  size of JPEG data
+        od_result:  OD result of the JPEG
+        config:     settings of the crop operation
+        crops:      array of MAX_OD_SUPPORT_OBJECTS crops, crops[i] is the crop of od_result->object[i]
+    @return:
+        number of valid crops
+    @remark: for JPEG_ROI_OUTPUT_JPEG the entropy decoding of the frame is shared by all crops,
+        call jpeg_roi_release() with od_result->object_num even if some crops are invalid
+*/
+uint8_t jpeg_roi_crop_objects(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_data_struct *od_result,
+    const struct jpeg_roi_config_struct *config, struct jpeg_roi_crop_struct *crops);
+
+/**
+    @brief: release the data of the crops
+    @parameter:
+        crops:      crops produced by jpeg_roi_crop_object() or jpeg_roi_crop_objects()
+        crop_num:   number of crops
+    @return:
+        (NONE)
+*/
+void jpeg_roi_release(struct jpeg_roi_crop_struct *crops, uint8_t crop_num);
+
+#endif // PLATFORM_POSIX
+
+#endif // JPEG_ROI_H
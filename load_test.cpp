@@ -0,0 +1,408 @@
+/** InstAI Co. (Public Version)
+    Description: Load generator and soak test of the host stack against the fake AI module
+    Modified Date: Oct 19, 2026
+    Remark: build on a Linux host with PLATFORM_HOST_SIM and AI_MODULE_LOAD_TEST defined
+        (e.g. g++ -DPLATFORM_HOST_SIM -DAI_MODULE_LOAD_TEST *.cpp -ljpeg -lpthread -o load_test),
+        the offered event rate is raised step by step, each step reports the delivered rate, the event latency
+        percentiles (from the due time of the event until the host cleared it), the lost events and the memory high-water mark.
+        With -v the test runs on the virtual clock, the polling and transfer delays only advance the time,
+        so that hours of load are simulated in seconds.
+        Run "./load_test -h" for the options.
+*/
+#include "ai_module.h"
+#include "fake_module.h"
+#include "poll_scheduler.h"
+
+#ifdef AI_MODULE_LOAD_TEST
+
+#ifndef PLATFORM_HOST_SIM
+    #error "AI_MODULE_LOAD_TEST requires PLATFORM_HOST_SIM to drive the fake AI module"
+#endif
+
+#include <signal.h>
+#include <getopt.h>
+#include <sys/resource.h>
+
+//-- Constant values
+#define PIN_CS  0
+#define PIN_RST 1
+#define LATENCY_SUB_BUCKETS     8       // buckets per power of two of the latency histogram
+#define LATENCY_BUCKETS         (32 * LATENCY_SUB_BUCKETS)
+#define SCHEDULE_HORIZON_US     100000  // events are scheduled on the fake module this long before they are due
+
+//-- Structures
+struct load_test_config_struct {
+    uint32_t duration_s;            // total test duration, 0 = until interrupted
+    uint32_t step_s;                // duration of each rate step
+    double start_rate;              // offered events per second of the first step
+    double rate_increment;          // added to the rate at each step
+    double max_rate;                // the rate stays at this value once reached
+    uint32_t burst_size;            // events offered back to back
+    uint32_t burst_gap_us;          // interval between the events of a burst
+    uint8_t object_num;             // objects reported by each event
+    uint32_t jpeg_size;             // size of the JPEG of each event, 0 = OD events only
+    uint32_t consumer_us;           // time spent by the JPEG consumer per JPEG
+    uint32_t spi_clock_hz;          // emulated SPI clock, 0 = no transfer delay
+    uint32_t poll_interval_us;      // fixed polling interval, 0 = adaptive polling scheduler
+    uint8_t drain_size;             // OD results per poll with ai_module_drain_events(), 0 = ai_module_process_event()
+    bool virtual_time;              // run on the virtual clock instead of the real-time clock
+};
+
+struct load_test_step_struct {
+    uint64_t offered;
+    uint64_t delivered;             // events cleared by the host
+    uint64_t lost;                  // events raised while the previous one was not cleared
+    uint64_t corrupted;             // events whose OD result or JPEG did not match the scheduled event
+    uint64_t latency[LATENCY_BUCKETS];
+    uint32_t latency_max_us;
+};
+
+/* ---- internal function prototypes declaration ---- */
+static void print_usage(const char *program);
+static bool parse_options(int argc, char **argv, struct load_test_config_struct *config);
+static void on_signal(int signal_number);
+static uint32_t latency_bucket(uint32_t latency_us);
+static uint32_t latency_bucket_floor(uint32_t bucket);
+static uint32_t latency_percentile(const struct load_test_step_struct *step, double percent);
+static void make_event(struct fake_module_event_struct *event, uint32_t id, uint32_t due_us);
+static void on_event_cleared(const struct fake_module_event_struct *event, uint32_t now_us);
+static void on_jpeg(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_struct *od_result);
+static bool same_od(const struct od_data_struct *a, const struct od_data_struct *b);
+static void report_step(uint32_t index, double rate, uint32_t elapsed_us, const struct load_test_step_struct *step);
+static void close_step(uint32_t index, double rate, uint32_t elapsed_us);
+
+//-- Global variables
+static struct load_test_config_struct config;
+static struct load_test_step_struct step, total;
+static volatile sig_atomic_t stop_requested = 0;
+static uint32_t random_state = 1;
+static struct od_data_struct cleared_od;       // OD result of the last cleared event
+static uint64_t lost_before = 0;
+static double max_sustained_rate = 0;
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options]\n"
+        "  -d seconds   total duration, 0 = until interrupted (default 600)\n"
+        "  -S seconds   duration of each rate step (default 30)\n"
+        "  -r rate      offered events per second of the first step (default 5)\n"
+        "  -a rate      rate increment per step (default 5)\n"
+        "  -R rate      maximum offered rate (default 100)\n"
+        "  -b events    burst size (default 1)\n"
+        "  -g us        interval between the events of a burst (default 0)\n"
+        "  -o objects   objects per event, 1 to %d (default 4)\n"
+        "  -j bytes     JPEG size per event, 0 = OD events only (default 0)\n"
+        "  -c us        JPEG consumer time per JPEG (default 0)\n"
+        "  -s hz        emulated SPI clock, 0 = no transfer delay (default 0)\n"
+        "  -p us        fixed polling interval, 0 = adaptive (default 0)\n"
+        "  -n events    drain up to this many OD results per poll, 0 = one status read per poll (default 0)\n"
+        "  -v           run on the virtual clock, faster than real time\n",
+        program, MAX_OD_SUPPORT_OBJECTS);
+}
+
+static bool parse_options(int argc, char **argv, struct load_test_config_struct *config)
+{
+    memset(config, 0, sizeof(struct load_test_config_struct));
+    config->duration_s = 600;
+    config->step_s = 30;
+    config->start_rate = 5;
+    config->rate_increment = 5;
+    config->max_rate = 100;
+    config->burst_size = 1;
+    config->object_num = 4;
+
+    int option;
+    while((option = getopt(argc, argv, "d:S:r:a:R:b:g:o:j:c:s:p:n:vh")) != -1)
+    {
+        switch(option)
+        {
+            case 'd': config->duration_s = strtoul(optarg, NULL, 10); break;
+            case 'S': config->step_s = strtoul(optarg, NULL, 10); break;
+            case 'r': config->start_rate = atof(optarg); break;
+            case 'a': config->rate_increment = atof(optarg); break;
+            case 'R': config->max_rate = atof(optarg); break;
+            case 'b': config->burst_size = strtoul(optarg, NULL, 10); break;
+            case 'g': config->burst_gap_us = strtoul(optarg, NULL, 10); break;
+            case 'o': config->object_num = (uint8_t)strtoul(optarg, NULL, 10); break;
+            case 'j': config->jpeg_size = strtoul(optarg, NULL, 10); break;
+            case 'c': config->consumer_us = strtoul(optarg, NULL, 10); break;
+            case 's': config->spi_clock_hz = strtoul(optarg, NULL, 10); break;
+            case 'p': config->poll_interval_us = strtoul(optarg, NULL, 10); break;
+            case 'n': config->drain_size = (uint8_t)strtoul(optarg, NULL, 10); break;
+            case 'v': config->virtual_time = true; break;
+            default: return false;
+        }
+    }
+
+    if(config->step_s == 0 || config->start_rate <= 0 || config->burst_size == 0 ||
+        config->object_num == 0 || config->object_num > MAX_OD_SUPPORT_OBJECTS || config->jpeg_size > AI_MODULE_BUFFER_SIZE)
+        return false;
+    if(config->max_rate < config->start_rate)
+        config->max_rate = config->start_rate;
+    return true;
+}
+
+static void on_signal(int signal_number)
+{
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+static uint32_t latency_bucket(uint32_t latency_us)
+{
+    // log-linear buckets: exact below LATENCY_SUB_BUCKETS, then LATENCY_SUB_BUCKETS buckets per power of two
+    if(latency_us < LATENCY_SUB_BUCKETS)
+        return latency_us;
+    uint32_t msb = 31 - __builtin_clz(latency_us);
+    uint32_t sub = (latency_us >> (msb - 3)) & (LATENCY_SUB_BUCKETS - 1);
+    return (msb - 2) * LATENCY_SUB_BUCKETS + sub;
+}
+
+static uint32_t latency_bucket_floor(uint32_t bucket)
+{
+    if(bucket < LATENCY_SUB_BUCKETS)
+        return bucket;
+    uint32_t msb = bucket / LATENCY_SUB_BUCKETS + 2;
+    uint32_t sub = bucket % LATENCY_SUB_BUCKETS;
+    return (LATENCY_SUB_BUCKETS + sub) << (msb - 3);
+}
+
+static uint32_t latency_percentile(const struct load_test_step_struct *step, double percent)
+{
+    if(step->delivered == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t)(step->delivered * percent / 100.0);
+    uint64_t count = 0;
+    for(uint32_t b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        count += step->latency[b];
+        if(count > rank)
+            return latency_bucket_floor(b);
+    }
+    return step->latency_max_us;
+}
+
+static void make_event(struct fake_module_event_struct *event, uint32_t id, uint32_t due_us)
+{
+    memset(event, 0, sizeof(struct fake_module_event_struct));
+    event->id = id;
+    event->due_us = due_us;
+    event->events = FAKE_MODULE_OD_EVENT | (config.jpeg_size > 0 ? FAKE_MODULE_JPEG_EVENT : 0);
+    event->jpeg_size = config.jpeg_size;
+
+    event->od.object_num = config.object_num;
+    for(uint8_t i = 0; i < config.object_num; i++)
+    {
+        random_state = random_state * 1103515245 + 12345;
+        struct od_object_unit_struct *object = &event->od.object[i];
+        object->center_x = (random_state >> 8) % AI_MODULE_FRAME_WIDTH;
+        object->center_y = (random_state >> 16) % AI_MODULE_FRAME_HEIGHT;
+        object->width = 16 + (random_state >> 4) % 64;
+        object->height = 16 + (random_state >> 12) % 64;
+        object->object_type = OD_OBJECT_TYPE_OFFSET + (id + i) % MAX_OD_SUPPORT_TYPES;
+        object->confidence_level = 50 + (random_state >> 20) % 50;
+    }
+}
+
+static void on_event_cleared(const struct fake_module_event_struct *event, uint32_t now_us)
+{
+    uint32_t latency_us = now_us - event->due_us;
+    memcpy(&cleared_od, &event->od, sizeof(struct od_data_struct));
+    step.delivered++;
+    step.latency[latency_bucket(latency_us)]++;
+    if(latency_us > step.latency_max_us)
+        step.latency_max_us = latency_us;
+}
+
+static void on_jpeg(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_struct *od_result)
+{
+    const struct fake_module_event_struct *event = fake_module_pending_event();
+    uint32_t id = jpeg_size >= 6 ? jpeg_data[2] | (jpeg_data[3] << 8) | (jpeg_data[4] << 16) | ((uint32_t)jpeg_data[5] << 24) : 0;
+
+    if(event == NULL || jpeg_size != (event->jpeg_size < 12 ? 12 : event->jpeg_size) || id != event->id ||
+        jpeg_data[0] != 0xFF || jpeg_data[1] != 0xD8 || jpeg_data[jpeg_size - 2] != 0xFF || jpeg_data[jpeg_size - 1] != 0xD9)
+        step.corrupted++;
+    (void)od_result;
+
+    // emulate the time taken by the application to store or forward the JPEG
+    if(config.consumer_us > 0)
+        interface_delay_us(config.consumer_us);
+}
+
+static bool same_od(const struct od_data_struct *a, const struct od_data_struct *b)
+{
+    if(a->object_num != b->object_num)
+        return false;
+    for(uint8_t i = 0; i < a->object_num; i++)
+    {
+        const struct od_object_unit_struct *x = &a->object[i], *y = &b->object[i];
+        if(x->center_x != y->center_x || x->center_y != y->center_y || x->width != y->width || x->height != y->height ||
+            x->object_type != y->object_type || x->confidence_level != y->confidence_level)
+            return false;
+    }
+    return true;
+}
+
+static void report_step(uint32_t index, double rate, uint32_t elapsed_us, const struct load_test_step_struct *step)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double seconds = elapsed_us / 1000000.0;
+    printf("%4u %9.1f %9.1f %8llu %8llu %9.2f %9.2f %9.2f %9.2f %9.2f %8ld\n", index, rate,
+        seconds > 0 ? step->delivered / seconds : 0.0, (unsigned long long)step->lost, (unsigned long long)step->corrupted,
+        latency_percentile(step, 50) / 1000.0, latency_percentile(step, 90) / 1000.0,
+        latency_percentile(step, 99) / 1000.0, latency_percentile(step, 99.9) / 1000.0,
+        step->latency_max_us / 1000.0, usage.ru_maxrss);
+    fflush(stdout);
+}
+
+static void close_step(uint32_t index, double rate, uint32_t elapsed_us)
+{
+    struct fake_module_stats_struct module_stats;
+    fake_module_get_stats(&module_stats);
+    step.lost = module_stats.events_lost - lost_before;
+    lost_before = module_stats.events_lost;
+    report_step(index, rate, elapsed_us, &step);
+
+    if(step.lost == 0 && step.corrupted == 0 && step.delivered > 0 && rate > max_sustained_rate)
+        max_sustained_rate = rate;
+    total.offered += step.offered;
+    total.delivered += step.delivered;
+    total.lost += step.lost;
+    total.corrupted += step.corrupted;
+    for(uint32_t b = 0; b < LATENCY_BUCKETS; b++)
+        total.latency[b] += step.latency[b];
+    if(step.latency_max_us > total.latency_max_us)
+        total.latency_max_us = step.latency_max_us;
+    memset(&step, 0, sizeof(step));
+}
+
+int main(int argc, char **argv)
+{
+    if(!parse_options(argc, argv, &config))
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    if(config.virtual_time)
+        interface_set_clock(interface_virtual_clock());
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    struct fake_module_config_struct module_config;
+    fake_module_default_config(&module_config);
+    module_config.spi_clock_hz = config.spi_clock_hz;
+    if(!interface_spi_init(fake_module_init(&module_config)) || !ai_module_init(PIN_CS, PIN_RST))
+    {
+        printf("AI Module cannot be initialized!\n");
+        return 1;
+    }
+    fake_module_register_cleared_func(on_event_cleared);
+    ai_module_register_save_jpeg_func(on_jpeg);
+    enum AI_MODULE_MODE mode = config.jpeg_size > 0 ? S_MOTION_OD_JPEG_MODE : OD_MODE;
+    ai_module_switch_mode(mode);
+
+    struct poll_scheduler_struct poll_scheduler;
+    poll_scheduler_init(&poll_scheduler, NULL);
+
+    printf("step   offered delivered     lost  corrupt   p50(ms)   p90(ms)   p99(ms) p99.9(ms)   max(ms) rss(KB)\n");
+
+    double rate = config.start_rate;
+    uint32_t step_index = 0, next_id = 0;
+    uint32_t start_us = interface_micros();
+    uint32_t step_start_us = start_us;
+    uint32_t next_due_us = start_us;
+    uint32_t burst_index = 0;
+    uint64_t elapsed_total_us = 0;
+    memset(&step, 0, sizeof(step));
+    memset(&total, 0, sizeof(total));
+
+    while(!stop_requested)
+    {
+        uint32_t now_us = interface_micros();
+
+        // offer the events due within the schedule horizon
+        while((int32_t)(next_due_us - now_us) < SCHEDULE_HORIZON_US)
+        {
+            struct fake_module_event_struct event;
+            make_event(&event, next_id, next_due_us);
+            if(!fake_module_schedule_event(&event))
+                break;
+            next_id++;
+            step.offered++;
+
+            burst_index++;
+            if(burst_index < config.burst_size)
+                next_due_us += config.burst_gap_us;
+            else
+            {   // the bursts are spaced so that the average offered rate is kept
+                burst_index = 0;
+                uint32_t period_us = (uint32_t)(1000000.0 * config.burst_size / rate);
+                uint32_t burst_us = (config.burst_size - 1) * config.burst_gap_us;
+                next_due_us += period_us > burst_us ? period_us - burst_us : 1;
+            }
+        }
+
+        // poll AI module as the application main loop does
+        bool is_obj_detected;
+        if(config.drain_size == 0)
+        {
+            struct od_data_struct od_event;
+            is_obj_detected = ai_module_process_event(&od_event);
+            if(is_obj_detected && !same_od(&od_event, &cleared_od))
+                step.corrupted++;
+        }
+        else
+        {   // only the last result of the batch can be compared with the last cleared event
+            static struct od_data_struct od_batch[UINT8_MAX];
+            uint8_t result_num = ai_module_drain_events(od_batch, config.drain_size, 0);
+            is_obj_detected = result_num > 0;
+            if(is_obj_detected && !same_od(&od_batch[result_num - 1], &cleared_od))
+                step.corrupted++;
+        }
+
+        // close the step
+        now_us = interface_micros();
+        if(now_us - step_start_us >= config.step_s * 1000000U)
+        {
+            close_step(step_index, rate, now_us - step_start_us);
+            elapsed_total_us += now_us - step_start_us;
+            step_start_us = now_us;
+            step_index++;
+            rate += config.rate_increment;
+            if(rate > config.max_rate)
+                rate = config.max_rate;
+            if(config.duration_s > 0 && elapsed_total_us >= (uint64_t)config.duration_s * 1000000)
+                break;
+        }
+
+        uint32_t interval_us = config.poll_interval_us > 0 ?
+            config.poll_interval_us : poll_scheduler_update(&poll_scheduler, mode, is_obj_detected);
+        interface_delay_us(interval_us);
+    }
+    if(step.offered > 0)    // interrupted in the middle of a step
+        close_step(step_index, rate, interface_micros() - step_start_us);
+
+    struct fake_module_stats_struct module_stats;
+    fake_module_get_stats(&module_stats);
+    printf("\nTotal: %llu offered, %llu delivered, %llu lost, %llu corrupted, %llu uncleared, %llu SPI transactions\n",
+        (unsigned long long)total.offered, (unsigned long long)total.delivered, (unsigned long long)total.lost,
+        (unsigned long long)total.corrupted, (unsigned long long)(fake_module_pending_event() != NULL ? 1 : 0),
+        (unsigned long long)module_stats.transactions);
+    printf("Latency: p50 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+        latency_percentile(&total, 50) / 1000.0, latency_percentile(&total, 99) / 1000.0,
+        latency_percentile(&total, 99.9) / 1000.0, total.latency_max_us / 1000.0);
+    printf("Maximum sustained rate without lost events: %.1f events/s\n", max_sustained_rate);
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    double wall_s = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    printf("Simulated %.1f s in %.1f s (%s clock)\n", (elapsed_total_us + (interface_micros() - step_start_us)) / 1000000.0,
+        wall_s, config.virtual_time ? "virtual" : "real-time");
+    return total.corrupted == 0 ? 0 : 1;
+}
+
+#endif // AI_MODULE_LOAD_TEST
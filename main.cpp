@@ -4,6 +4,20 @@
 */
 
 #include "ai_module.h"
+#include "poll_scheduler.h"
+#include "threshold_controller.h"
+#include "occupancy_analytics.h"
+#include "zone_rules.h"
+#ifdef PLATFORM_POSIX
+#include "jpeg_roi.h"
+#include "jpeg_dedup.h"
+#include "shm_publisher.h"
+#include "event_server.h"
+#include "rt_loop.h"
+#include "frame_ring.h"
+#include "spi_trace.h"
+#include <signal.h>
+#endif
 
 #ifdef PLATFORM_RASPI
     // define pin number of CS, RST connected to your host
@@ -21,13 +35,83 @@
     // pull to ground when it's not pressed
     #define USER_BUTTON_PIN 4
 
+#elif defined PLATFORM_HOST_SIM
+    // pins are not used on the simulated host
+    #define PIN_CS  0
+    #define PIN_RST 1
+    #define USER_BUTTON_PIN 2
+
+    // replay the SPI trace recorded on the target platform (see spi_trace.h)
+    #define SPI_TRACE_REPLAY_FILE   "spi_trace.bin"
+    // select one from SPI_TRACE_REPLAY_AS_FAST_AS_POSSIBLE or SPI_TRACE_REPLAY_ORIGINAL_TIMING
+    #define SPI_TRACE_REPLAY_PACING SPI_TRACE_REPLAY_AS_FAST_AS_POSSIBLE
+    // uncomment the following line to run on a virtual clock: the delays of the driver and of the main loop
+    // only advance the time, so that a session of hours replays in seconds (see interface_virtual_clock())
+    //#define VIRTUAL_TIME
+
 #else   // define your hardware platform here other than Raspberry Pi or Arduino
 
 #endif
 
-// define message display method on your platform
 #ifdef PLATFORM_RASPI
-    #define GENERAL_PRINT(x) printf(x)
+    // uncomment the following line to also save the crop of each detected object next to the JPEG (see jpeg_roi.h)
+    //#define SAVE_OBJECT_CROPS
+    #define OBJECT_CROP_WORKERS 2   // number of threads cropping the objects of a frame
+    // uncomment the following line to replace near-duplicate JPEGs by a reference to the recently saved one (see jpeg_dedup.h)
+    //#define SKIP_DUPLICATE_JPEG
+    #define DEDUP_REPORT_S      60      // interval of the near-duplicate report
+    // uncomment the following line to keep the JPEGs in RAM and only write the frames around an incident as clips (see frame_ring.h)
+    //#define BUFFER_JPEG_CLIPS
+#endif
+
+#ifdef BUFFER_JPEG_CLIPS
+    #define JPEG_CLIP_DIRECTORY "."     // directory of the clip files
+#endif
+
+#ifdef PLATFORM_POSIX
+    // uncomment the following line to publish OD results and JPEGs to other processes through shared memory (see shm_publisher.h)
+    //#define PUBLISH_SHARED_MEMORY
+    #define SHARED_MEMORY_NAME  "/ai_module_events"
+
+    // uncomment the following line to serve OD results and JPEGs to local processes over a Unix domain socket (see event_server.h)
+    //#define EVENT_SERVER_DAEMON
+    #define EVENT_SERVER_SOCKET_PATH    "/tmp/ai_module.sock"
+    #define EVENT_SERVER_SOCKET_MODE    0666    // clients of any user can connect
+
+    // uncomment the following line to poll AI module on a real-time thread with bounded response time (see rt_loop.h)
+    //#define REAL_TIME_POLLING
+    #define REAL_TIME_PERIOD_US     1000    // polling period of the real-time thread
+    #define REAL_TIME_CPU           -1      // CPU the real-time thread is pinned on, -1 = any CPU
+    #define REAL_TIME_REPORT_S      60      // interval of the jitter report
+    #define REAL_TIME_MAIN_LOOP_US  5000    // period of the main loop draining the OD results and JPEGs of the real-time thread
+#endif
+
+// the AI module is polled at the interval of the poll scheduler (see poll_scheduler.h), the user button more often,
+// unless AI module is polled by the real-time thread
+#define USER_BUTTON_SAMPLE_US   10000   // the user button is sampled at least this often
+#define POLL_REPORT_S           60      // interval of the polling report
+
+// uncomment the following line to raise/lower the OD thresholds of each object type to cap its event rate (see threshold_controller.h)
+//#define ADAPTIVE_OD_THRESHOLD
+
+// uncomment the following line to report the 1-minute/15-minute/1-hour occupancy of each object type (see occupancy_analytics.h)
+//#define OCCUPANCY_ANALYTICS
+#ifdef OCCUPANCY_ANALYTICS
+    #define OCCUPANCY_GAP_LIMIT_MS  5000    // an object type not detected for longer than this is considered gone
+    #define OCCUPANCY_REPORT_S      60      // interval of the occupancy report
+#endif
+
+// uncomment the following line to fire zone and line-crossing rules on the detected objects (see zone_rules.h)
+//#define EVALUATE_ZONE_RULES
+
+#ifdef AI_MODULE_SPI_TRACE
+    // record every SPI transaction of the session into this file
+    #define SPI_TRACE_CAPTURE_FILE  "spi_trace_capture.bin"
+#endif
+
+// define message display method on your platform
+#if defined PLATFORM_RASPI || defined PLATFORM_HOST_SIM
+    #define GENERAL_PRINT(x) printf("%s", x)
 #elif defined PLATFORM_ARDUINO
     #define GENERAL_PRINT(x) Serial.print(x)
 #else   // define your hardware platform here other than Raspberry Pi or Arduino
@@ -40,6 +124,9 @@ struct user_setting_struct
 
     // available values JPEG_QUALITY_LOW_VAL, JPEG_QUALITY_DEFAULT_MEDIUM_VAL, JPEG_QUALITY_HIGH_VAL
     enum JPEG_QUALITY jpeg_quality_value;
+
+    // frames retrieved for each JPEG event, JPEG_FRAME_DEFAULT or bitwise OR of JPEG_FRAME_MOTION, JPEG_FRAME_OD, JPEG_FRAME_CURRENT
+    uint8_t jpeg_frames;
 };
 
 /* --------- (Provides by InstAI Co.) set AI module's OD event triggering threshold values of each object type --------- */
@@ -48,6 +135,149 @@ const uint8_t ai_module_od_thresholds[MAX_OD_SUPPORT_TYPES] = {50, 50, 50, 50, 5
 // declare global variable user_setting to store AI Module's settings
 struct user_setting_struct user_setting;
 
+#ifdef SKIP_DUPLICATE_JPEG
+// recently saved JPEGs compared with the received ones
+struct jpeg_dedup_struct jpeg_dedup;
+#endif
+
+#ifdef SKIP_DUPLICATE_JPEG
+void Print_Dedup_Report()
+{
+    char display_buffer[160];
+    struct jpeg_dedup_stats_struct stats;
+    jpeg_dedup_get_stats(&jpeg_dedup, &stats);
+    sprintf(display_buffer, "Near-duplicate JPEGs: %lu of %lu frames skipped (%lu errors), %llu of %llu bytes saved\n",
+        (unsigned long)stats.duplicates, (unsigned long)stats.frames, (unsigned long)stats.errors,
+        (unsigned long long)stats.bytes_saved, (unsigned long long)stats.bytes_total);
+    GENERAL_PRINT(display_buffer);
+}
+#endif
+
+#ifdef BUFFER_JPEG_CLIPS
+// recent JPEGs waiting for an incident
+struct frame_ring_struct frame_ring;
+#endif
+
+#ifndef REAL_TIME_POLLING
+// polling interval of the main loop, adapted to the AI module mode and the recent events
+struct poll_scheduler_struct poll_scheduler;
+
+void Print_Poll_Report()
+{
+    char display_buffer[160];
+    struct poll_scheduler_stats_struct stats;
+    poll_scheduler_get_stats(&poll_scheduler, &stats);
+    sprintf(display_buffer, "Polling: %lu polls, %lu events, interval %lu us, average event gap %lu ms\n",
+        (unsigned long)stats.polls, (unsigned long)stats.events, (unsigned long)stats.interval_us,
+        (unsigned long)(stats.event_gap_avg_us / 1000));
+    GENERAL_PRINT(display_buffer);
+}
+#endif
+
+#ifdef ADAPTIVE_OD_THRESHOLD
+// OD thresholds adjusted to keep the event rate of each object type within its budget
+struct threshold_controller_struct threshold_controller;
+
+void Threshold_Adjusted_Log(uint8_t type_index, uint8_t old_threshold, uint8_t new_threshold, uint16_t events, uint16_t budget)
+{
+    char display_buffer[120];
+    sprintf(display_buffer, "OD threshold of type %d: %d -> %d (%d events, budget %d)\n", type_index + OD_OBJECT_TYPE_OFFSET,
+        old_threshold, new_threshold, events, budget);
+    GENERAL_PRINT(display_buffer);
+}
+#endif
+
+#ifdef OCCUPANCY_ANALYTICS
+// per-type occupancy of the recent minute, quarter and hour
+struct occupancy_analytics_struct occupancy;
+
+void Print_Occupancy_Report()
+{
+    static const char *window_names[OCCUPANCY_WINDOWS] = {"1m", "15m", "1h"};
+    char display_buffer[160];
+    uint32_t now_us = interface_micros();
+    for(uint8_t t = 0; t < MAX_OD_SUPPORT_TYPES; t++)
+    {
+        struct occupancy_stats_struct stats;
+        occupancy_analytics_query(&occupancy, t, OCCUPANCY_WINDOW_1_HOUR, now_us, &stats);
+        if(stats.events == 0)
+            continue;   // no activity of the type in the last hour
+
+        for(uint8_t w = 0; w < OCCUPANCY_WINDOWS; w++)
+        {
+            occupancy_analytics_query(&occupancy, t, (enum OCCUPANCY_WINDOW)w, now_us, &stats);
+            sprintf(display_buffer, "Occupancy of type %d (%s): %lu detections, %lu visits, peak %d, present %lu s, "
+                "average dwell %lu ms, current dwell %lu ms\n", t + OD_OBJECT_TYPE_OFFSET, window_names[w],
+                (unsigned long)stats.detections, (unsigned long)stats.visits, stats.peak_occupancy,
+                (unsigned long)(stats.presence_ms / 1000), (unsigned long)stats.average_dwell_ms, (unsigned long)stats.current_dwell_ms);
+            GENERAL_PRINT(display_buffer);
+        }
+    }
+}
+#endif
+
+#ifdef EVALUATE_ZONE_RULES
+// zones rasterized once at setup, looked up for every detected object
+struct zone_rules_struct zone_rules;
+
+void Zone_Rule_Fired(uint8_t rule_index, const struct zone_rule_unit_struct *rule, const struct od_object_unit_struct *object)
+{
+    static const char *rule_names[] = {"is in", "entered", "left", "crossed the line from"};
+    char display_buffer[120];
+    sprintf(display_buffer, "Rule %d: object of type %d at (%lu, %lu) %s zone %d\n", rule_index, object->object_type,
+        (unsigned long)object->center_x, (unsigned long)object->center_y, rule_names[rule->type], rule->zone);
+    GENERAL_PRINT(display_buffer);
+
+    // do other operations when a rule fires...
+
+}
+
+void Prepare_Zone_Rules(struct zone_rules_struct *rules)
+{
+    // sample zones: the left third of the frame, and a vertical line across the middle of the frame
+    const struct zone_point_struct left_area[4] = {{0, 0}, {AI_MODULE_FRAME_WIDTH / 3, 0},
+        {AI_MODULE_FRAME_WIDTH / 3, AI_MODULE_FRAME_HEIGHT}, {0, AI_MODULE_FRAME_HEIGHT}};
+    const struct zone_point_struct line_from = {AI_MODULE_FRAME_WIDTH / 2, 0};
+    const struct zone_point_struct line_to = {AI_MODULE_FRAME_WIDTH / 2, AI_MODULE_FRAME_HEIGHT};
+
+    zone_rules_init(rules, 40);
+    zone_rules_register_fired_func(rules, Zone_Rule_Fired);
+    uint8_t area = zone_rules_add_polygon(rules, left_area, 4);
+    zone_rules_add_rule(rules, ZONE_RULE_ENTER, area, 0);
+    zone_rules_add_rule(rules, ZONE_RULE_EXIT, area, 0);
+    uint8_t line_side = zone_rules_add_line(rules, line_from, line_to, 30);
+    zone_rules_add_rule(rules, ZONE_RULE_CROSS, line_side, 0);
+    zone_rules_add_rule(rules, ZONE_RULE_CROSS, line_side + 1, 0);
+}
+#endif
+
+#ifdef REAL_TIME_POLLING
+#ifdef ADAPTIVE_OD_THRESHOLD
+// threshold adjustments access AI module, so they are executed on the real-time thread
+void Threshold_Controller_Poll(void *arg)
+{
+    (void)arg;
+    threshold_controller_poll(&threshold_controller, interface_micros());
+}
+#endif
+
+void Print_Realtime_Report()
+{
+    char display_buffer[200];
+    struct rt_loop_stats_struct stats;
+    rt_loop_get_stats(&stats);
+    sprintf(display_buffer, "Real-time polling (%s%s%s): %llu cycles, %llu overruns, %llu events, %llu dropped, %llu JPEGs dropped\n",
+        stats.realtime ? "SCHED_FIFO" : "normal priority", stats.affinity ? ", pinned" : "", stats.memory_locked ? ", locked" : "",
+        (unsigned long long)stats.cycles, (unsigned long long)stats.overruns, (unsigned long long)stats.events,
+        (unsigned long long)stats.queue_dropped, (unsigned long long)stats.jpeg_dropped);
+    GENERAL_PRINT(display_buffer);
+    sprintf(display_buffer, "  wake-up latency p99 < %u us, p99.9 < %u us, max %u us; service max %u us; response max %u us\n",
+        rt_loop_histogram_percentile(stats.wakeup_histogram, 99), rt_loop_histogram_percentile(stats.wakeup_histogram, 99.9),
+        stats.wakeup_max_us, stats.service_max_us, stats.response_max_us);
+    GENERAL_PRINT(display_buffer);
+}
+#endif
+
 /* --------- set your application requirements here --------- */
 void prepare_user_setting_variable(struct user_setting_struct *setting)
 {
@@ -58,12 +288,29 @@ void prepare_user_setting_variable(struct user_setting_struct *setting)
 
     // Select JPEG quality from JPEG_QUALITY_LOW_VAL, JPEG_QUALITY_DEFAULT_MEDIUM_VAL, JPEG_QUALITY_HIGH_VAL
     setting->jpeg_quality_value = JPEG_QUALITY_DEFAULT_MEDIUM_VAL;
+
+    // Select the frames to save from JPEG_FRAME_DEFAULT, or any of JPEG_FRAME_MOTION | JPEG_FRAME_OD | JPEG_FRAME_CURRENT
+    setting->jpeg_frames = JPEG_FRAME_DEFAULT;
 }
 
-// the function to store OD triggered pictures and results received from AI module
-void Platform_JPEG_Save(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_struct *od_result)
+// store OD triggered pictures and results received from AI module, jpeg_frame tells the selected frames apart
+void Save_JPEG(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_data_struct *od_result, enum AI_MODULE_JPEG_FRAME jpeg_frame)
 {
+#ifdef PUBLISH_SHARED_MEMORY
+    shm_publisher_publish_jpeg(jpeg_data, jpeg_size, od_result);
+#endif
+#ifdef EVENT_SERVER_DAEMON
+    event_server_publish_jpeg(jpeg_data, jpeg_size, od_result);
+#endif
+
 #ifdef PLATFORM_RASPI
+#ifdef BUFFER_JPEG_CLIPS
+    // the JPEG is written later with the clip of an incident, or never
+    frame_ring_feed(&frame_ring, jpeg_data, jpeg_size, od_result, jpeg_frame);
+    return;
+#else
+    (void)jpeg_frame;   // only the clips tell the selected frames apart
+#endif
     static unsigned long jpeg_num = 0;
     jpeg_num += 1;
 
@@ -74,9 +321,24 @@ void Platform_JPEG_Save(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_str
 
     // save JPEG file
     sprintf(file_name, "%04d%02d%02d%02d%02d%02d_%d.jpg", 1900 + ltm->tm_year, 1 + ltm->tm_mon, ltm->tm_mday, ltm->tm_hour, ltm->tm_min, ltm->tm_sec, jpeg_num);
-    fp = fopen(file_name, "wb");
-    fwrite(jpeg_data, 1, jpeg_size, fp);
-    fclose(fp);
+    const char *duplicate_of = NULL;
+#ifdef SKIP_DUPLICATE_JPEG
+    // a near-duplicate of a recently saved JPEG is not saved, a .ref file names the saved JPEG instead
+    jpeg_dedup_process(&jpeg_dedup, jpeg_data, jpeg_size, od_result, file_name, &duplicate_of);
+#endif
+    if(duplicate_of == NULL)
+    {
+        fp = fopen(file_name, "wb");
+        fwrite(jpeg_data, 1, jpeg_size, fp);
+        fclose(fp);
+    }
+    else
+    {   // the reference is kept out of the CSV file so that its format is unchanged
+        sprintf(file_name, "%04d%02d%02d%02d%02d%02d_%d.ref", 1900 + ltm->tm_year, 1 + ltm->tm_mon, ltm->tm_mday, ltm->tm_hour, ltm->tm_min, ltm->tm_sec, jpeg_num);
+        fp = fopen(file_name, "wt");
+        fprintf(fp, "%s\n", duplicate_of);
+        fclose(fp);
+    }
 
     // save OD result
     if(od_result != NULL)
@@ -94,6 +356,33 @@ void Platform_JPEG_Save(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_str
         }
         fclose(fp);
     }
+
+#ifdef SAVE_OBJECT_CROPS
+    // save the lossless crop of each object, the full frame is not decoded
+    if(od_result != NULL && duplicate_of == NULL)
+    {
+        struct jpeg_roi_config_struct crop_config = { JPEG_ROI_OUTPUT_JPEG, 10, 0 };
+        struct jpeg_roi_crop_struct crops[MAX_OD_SUPPORT_OBJECTS];
+        uint8_t crop_num = od_result->object_num < MAX_OD_SUPPORT_OBJECTS ? od_result->object_num : MAX_OD_SUPPORT_OBJECTS;
+        jpeg_roi_crop_objects(jpeg_data, jpeg_size, od_result, &crop_config, crops);
+        for(uint8_t i = 0; i < crop_num; i++)
+        {
+            if(!crops[i].valid)
+                continue;
+            sprintf(file_name, "%04d%02d%02d%02d%02d%02d_%lu_obj%d.jpg", 1900 + ltm->tm_year, 1 + ltm->tm_mon, ltm->tm_mday, ltm->tm_hour, ltm->tm_min, ltm->tm_sec, jpeg_num, i);
+            fp = fopen(file_name, "wb");
+            fwrite(crops[i].data, 1, crops[i].size, fp);
+            fclose(fp);
+        }
+        jpeg_roi_release(crops, crop_num);
+    }
+#endif
+#elif defined PLATFORM_HOST_SIM
+    // the replayed JPEGs are not stored
+    (void)jpeg_data;
+    (void)jpeg_size;
+    (void)od_result;
+    (void)jpeg_frame;
 #elif defined PLATFORM_ARDUINO
 
 #else   // other platform...
@@ -101,6 +390,12 @@ void Platform_JPEG_Save(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_str
 #endif
 }
 
+// the function registered to AI module, called when a JPEG is received
+void Platform_JPEG_Save(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_struct *od_result)
+{
+    Save_JPEG(jpeg_data, jpeg_size, od_result, ai_module_get_jpeg_frame());
+}
+
 void setup()
 {
     char display_buffer[120];
@@ -131,21 +426,66 @@ void setup()
     * }
     */
 
+#elif defined PLATFORM_HOST_SIM
+#ifdef VIRTUAL_TIME
+    interface_set_clock(interface_virtual_clock());
+#endif
+    if(!spi_trace_replay_open(SPI_TRACE_REPLAY_FILE, SPI_TRACE_REPLAY_PACING) ||
+        !interface_spi_init(spi_trace_replay_device())) {
+        GENERAL_PRINT("Cannot load SPI trace " SPI_TRACE_REPLAY_FILE "!\n");
+        exit(1);    // nothing to replay
+    }
+
 #else   // other platform...
 
+#endif
+
+#ifdef AI_MODULE_SPI_TRACE
+    // start recording before AI module initialization to capture the whole session
+    if(!spi_trace_capture_start(SPI_TRACE_CAPTURE_FILE))
+        GENERAL_PRINT("Cannot create SPI trace " SPI_TRACE_CAPTURE_FILE "!\n");
 #endif
 
     // initialize user button pin as input
     interface_gpio_input(USER_BUTTON_PIN);
 
     // register the function when JPEG recieved in OD_JPEG_MODE or S_MOTION_OD_JPEG_MODE
+#ifdef REAL_TIME_POLLING
+    // the real-time thread only copies the JPEGs, they are saved and published by the main loop
+    ai_module_register_save_jpeg_func(rt_loop_queue_jpeg);
+#else
     ai_module_register_save_jpeg_func(Platform_JPEG_Save);
+#endif
+#ifdef SAVE_OBJECT_CROPS
+    jpeg_roi_init(OBJECT_CROP_WORKERS);
+#endif
+#ifdef PUBLISH_SHARED_MEMORY
+    if(!shm_publisher_open(SHARED_MEMORY_NAME, SHM_RING_DEFAULT_SLOTS))
+        GENERAL_PRINT("Cannot create shared memory " SHARED_MEMORY_NAME "!\n");
+#endif
+#ifdef EVENT_SERVER_DAEMON
+    if(!event_server_open(EVENT_SERVER_SOCKET_PATH, EVENT_SERVER_SOCKET_MODE))
+        GENERAL_PRINT("Cannot listen on " EVENT_SERVER_SOCKET_PATH "!\n");
+#endif
+#ifdef SKIP_DUPLICATE_JPEG
+    // use the recommended thresholds, customize with jpeg_dedup_default_config() if needed
+    jpeg_dedup_init(&jpeg_dedup, NULL);
+#endif
+#ifdef BUFFER_JPEG_CLIPS
+    // use the default ring size and trigger, customize with frame_ring_default_config() if needed
+    if(!frame_ring_init(&frame_ring, NULL, frame_ring_file_sink, (void *)JPEG_CLIP_DIRECTORY))
+        GENERAL_PRINT("Cannot allocate the JPEG ring!\n");
+#endif
 
     // initialize AI module
     while(!ai_module_init(PIN_CS, PIN_RST))
     {
         GENERAL_PRINT("AI Module cannot be initialized!\n");
-        usleep(200000);
+#ifdef PLATFORM_HOST_SIM
+        if(spi_trace_replay_finished())
+            exit(1);    // the trace does not contain a successful initialization
+#endif
+        interface_delay_us(200000);
     }
     GENERAL_PRINT("AI Module initialized successfully!\n");
 
@@ -161,33 +501,90 @@ void setup()
 
     // set 21 object type OD event triggering threshold values of AI module
     ai_module_set_od_threshold(ai_module_od_thresholds);
+#ifdef ADAPTIVE_OD_THRESHOLD
+    // use the recommended event budgets and bounds, customize with threshold_controller_default_config() if needed
+    threshold_controller_init(&threshold_controller, NULL, ai_module_od_thresholds, interface_micros());
+    threshold_controller_register_log_func(&threshold_controller, Threshold_Adjusted_Log);
+#endif
+#ifdef OCCUPANCY_ANALYTICS
+    occupancy_analytics_init(&occupancy, OCCUPANCY_GAP_LIMIT_MS, interface_micros());
+#endif
+#ifdef EVALUATE_ZONE_RULES
+    Prepare_Zone_Rules(&zone_rules);
+#endif
 
     // user settings for operation mode/JPEG settings
     prepare_user_setting_variable(&user_setting);
     // set user setting to AI module
     ai_module_set_jpeg_quality(user_setting.jpeg_quality_value);
+    ai_module_set_jpeg_frames(user_setting.jpeg_frames);
     ai_module_switch_mode(user_setting.operation_mode);
+
+#ifdef REAL_TIME_POLLING
+    // from now on, AI module is polled and accessed by the real-time thread only
+    struct rt_loop_config_struct rt_config;
+    rt_loop_default_config(&rt_config);
+    rt_config.period_us = REAL_TIME_PERIOD_US;
+    rt_config.cpu = REAL_TIME_CPU;
+    if(!rt_loop_start(&rt_config, NULL))    // give a function to react to the OD results on the real-time thread
+        GENERAL_PRINT("Cannot start the real-time polling thread!\n");
+#else
+    // use the recommended polling interval bounds, customize with poll_scheduler_default_config() if needed
+    poll_scheduler_init(&poll_scheduler, NULL);
+#endif
 }
 
 void loop()
 {
     char display_buffer[120];
     static uint32_t rec_counter = 0;
+#ifdef REAL_TIME_POLLING
+    enum AI_MODULE_MODE mode = rt_loop_get_mode();
+    bool is_poll_due = true;    // the queues of the real-time thread are drained in every iteration
+#else
+    enum AI_MODULE_MODE mode = ai_module_get_mode();
+    bool is_obj_detected = false;
+    static uint32_t poll_last_us = interface_micros();
+    static uint32_t poll_interval_us = 0;
+    uint32_t now_us = interface_micros();
+    bool is_poll_due = now_us - poll_last_us >= poll_interval_us;
+#endif
 
-    switch(ai_module_get_mode())
+    switch(mode)
     {
     case IDLE_MODE:
     break;
 
     default:
+    if(is_poll_due)
     {
         // detect whether there is any event triggered
         struct od_data_struct od_event;
-        bool is_obj_detected = ai_module_process_event(&od_event); // event polling mode
+#ifdef REAL_TIME_POLLING
+        // read all the OD results retrieved by the real-time thread since the last iteration
+        while(rt_loop_pop_od(&od_event))
+#else
+        is_obj_detected = ai_module_process_event(&od_event); // event polling mode
 
         // read OD information if OD event triggered
         if(is_obj_detected)
+#endif
         {
+#ifdef PUBLISH_SHARED_MEMORY
+            shm_publisher_publish_od(&od_event);
+#endif
+#ifdef EVENT_SERVER_DAEMON
+            event_server_publish_od(&od_event);
+#endif
+#ifdef ADAPTIVE_OD_THRESHOLD
+            threshold_controller_feed(&threshold_controller, &od_event);
+#endif
+#ifdef OCCUPANCY_ANALYTICS
+            occupancy_analytics_feed(&occupancy, &od_event, interface_micros());
+#endif
+#ifdef EVALUATE_ZONE_RULES
+            zone_rules_evaluate(&zone_rules, &od_event);
+#endif
             sprintf(display_buffer, "AI Module Detected Objects: %d\n", od_event.object_num);
             GENERAL_PRINT(display_buffer);
             if(od_event.object_num > 0)
@@ -210,13 +607,23 @@ void loop()
     break;
     }
 
+#ifdef REAL_TIME_POLLING
+    // save the JPEGs copied by the real-time thread
+    const struct rt_loop_jpeg_struct *jpeg;
+    while((jpeg = rt_loop_peek_jpeg()) != NULL)
+    {
+        Save_JPEG(jpeg->data, jpeg->size, jpeg->has_od_result ? &jpeg->od_result : NULL, jpeg->jpeg_frame);
+        rt_loop_release_jpeg();
+    }
+#endif
+
     // detect whether user pressed the button with debounce
     static bool btn_last_state = false;
     static uint8_t debounce_counter = 0;
     bool user_button_state = interface_digital_read(USER_BUTTON_PIN);
     if(user_button_state != btn_last_state)
     {
-        usleep(20000);  // delay for 20 ms
+        interface_delay_us(20000);  // delay for 20 ms
         user_button_state = interface_digital_read(USER_BUTTON_PIN);
         if(user_button_state != btn_last_state)
         {
@@ -246,7 +653,12 @@ void loop()
                 }
 
                 // update with new user operation mode
+#ifdef REAL_TIME_POLLING
+                rt_loop_switch_mode(user_setting.operation_mode);
+#else
                 ai_module_switch_mode(user_setting.operation_mode);
+                poll_interval_us = 0;   // poll the new mode right away
+#endif
                 debounce_counter = 0;
             }
             btn_last_state = user_button_state;
@@ -255,16 +667,132 @@ void loop()
 
     // do other operations in main loop...
 
-    usleep(10000);  // delay for 10 milliseconds
+#ifdef ADAPTIVE_OD_THRESHOLD
+    // adjust the thresholds at the end of each control window
+#ifdef REAL_TIME_POLLING
+    // hand the adjustment over to the real-time thread only when the window is elapsed, it waits for the thread
+    if(threshold_controller_is_due(&threshold_controller, interface_micros()))
+        rt_loop_execute(Threshold_Controller_Poll, NULL);
+#else
+    threshold_controller_poll(&threshold_controller, interface_micros());
+#endif
+#endif
+
+#ifdef SKIP_DUPLICATE_JPEG
+    static uint32_t dedup_report_last_us = interface_micros();
+    if(interface_micros() - dedup_report_last_us >= DEDUP_REPORT_S * 1000000U)
+    {
+        Print_Dedup_Report();
+        dedup_report_last_us = interface_micros();
+    }
+#endif
+
+#ifdef OCCUPANCY_ANALYTICS
+    occupancy_analytics_tick(&occupancy, interface_micros());
+    static uint32_t occupancy_report_last_us = interface_micros();
+    if(interface_micros() - occupancy_report_last_us >= OCCUPANCY_REPORT_S * 1000000U)
+    {
+        Print_Occupancy_Report();
+        occupancy_report_last_us = interface_micros();
+    }
+#endif
+
+#ifdef REAL_TIME_POLLING
+    static uint32_t report_last_us = interface_micros();
+    if(interface_micros() - report_last_us >= REAL_TIME_REPORT_S * 1000000U)
+    {
+        Print_Realtime_Report();
+        report_last_us = interface_micros();
+    }
+#endif
+
+#ifndef REAL_TIME_POLLING
+    static uint32_t poll_report_last_us = interface_micros();
+    if(interface_micros() - poll_report_last_us >= POLL_REPORT_S * 1000000U)
+    {
+        Print_Poll_Report();
+        poll_report_last_us = interface_micros();
+    }
+#endif
+
+#ifdef EVENT_SERVER_DAEMON
+    // accept clients and send the messages queued in this iteration, never blocks
+    event_server_poll();
+#endif
+
+#ifdef REAL_TIME_POLLING
+    // AI module is polled by the real-time thread, wait shortly for its next results
+    interface_delay_us(REAL_TIME_MAIN_LOOP_US);
+#else
+    if(is_poll_due)
+    {   // poll faster right after an OD event, back off while AI module stays quiet
+        poll_interval_us = poll_scheduler_update(&poll_scheduler, mode, is_obj_detected);
+        poll_last_us = now_us;
+    }
+
+    // sleep until the next poll, but wake up in time to sample the user button
+    uint32_t poll_elapsed_us = interface_micros() - poll_last_us;
+    uint32_t delay_us = poll_elapsed_us < poll_interval_us ? poll_interval_us - poll_elapsed_us : 0;
+    interface_delay_us(delay_us < USER_BUTTON_SAMPLE_US ? delay_us : USER_BUTTON_SAMPLE_US);
+#endif
+}
+
+#if !defined PLATFORM_ARDUINO && !defined AI_MODULE_LOAD_TEST
+#ifdef PLATFORM_POSIX
+// set by SIGINT/SIGTERM to leave the main loop
+volatile sig_atomic_t stop_requested = 0;
+
+void Request_Stop(int signal_number)
+{
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+// complete the pending work before exiting
+void Stop_Program()
+{
+#ifdef REAL_TIME_POLLING
+    // the real-time thread no longer accesses AI module after this
+    rt_loop_stop();
+#endif
+#ifdef BUFFER_JPEG_CLIPS
+    // write the clip being completed with the post-roll frames received so far
+    frame_ring_flush(&frame_ring);
+    frame_ring_release(&frame_ring);
+#endif
+#ifdef AI_MODULE_SPI_TRACE
+    spi_trace_capture_stop();
+#endif
 }
+#endif
 
-#ifndef PLATFORM_ARDUINO
-// implement function main() if host platform is not Arduino
+// implement function main() if host platform is not Arduino (the load test provides its own, see load_test.cpp)
 int main()
 {
+#ifdef PLATFORM_POSIX
+    signal(SIGINT, Request_Stop);
+    signal(SIGTERM, Request_Stop);
+#endif
     setup();
 
+#ifdef PLATFORM_HOST_SIM
+    // run the driver until every recorded transaction has been replayed
+    while(!stop_requested && !spi_trace_replay_finished()) loop();
+    Stop_Program();
+
+    struct spi_trace_replay_stats_struct stats;
+    spi_trace_replay_get_stats(&stats);
+    printf("Replayed %u/%u SPI transactions (%u mismatches, %u written values) in %.3f s, recorded duration %.3f s\n",
+        stats.transactions, stats.total_transactions, stats.mismatches, stats.value_mismatches,
+        stats.elapsed_us / 1000000.0, stats.recorded_us / 1000000.0);
+    spi_trace_replay_close();
+    return stats.mismatches == 0 ? 0 : 1;
+#elif defined PLATFORM_POSIX
+    while(!stop_requested) loop();
+    Stop_Program();
+#else
     while(true) loop();
+#endif
 
     return 0;
 }
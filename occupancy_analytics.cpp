@@ -0,0 +1,170 @@
+/** InstAI Co. (Public Version)
+    Description: Streaming per-object-type occupancy analytics over 1-minute, 15-minute and 1-hour sliding windows
+    Modified Date: Oct 19, 2026
+*/
+#include "occupancy_analytics.h"
+
+//-- Constant values
+// duration of a bucket of each window
+static const uint32_t bucket_ms[OCCUPANCY_WINDOWS] = {
+    60000UL / OCCUPANCY_BUCKETS,
+    900000UL / OCCUPANCY_BUCKETS,
+    3600000UL / OCCUPANCY_BUCKETS
+};
+
+/* ---- internal function prototypes declaration ---- */
+static void advance_clock(struct occupancy_analytics_struct *occupancy, uint32_t now_us);
+static void advance_window(struct occupancy_window_struct *window, uint32_t head);
+static void update_peak(struct occupancy_window_struct *window, uint8_t count);
+static void update_presence(struct occupancy_analytics_struct *occupancy, struct occupancy_type_struct *type);
+
+void occupancy_analytics_init(struct occupancy_analytics_struct *occupancy, uint32_t gap_limit_ms, uint32_t now_us)
+{
+    memset(occupancy, 0, sizeof(struct occupancy_analytics_struct));
+    occupancy->gap_limit_ms = gap_limit_ms;
+    occupancy->last_us = now_us;
+}
+
+static void advance_clock(struct occupancy_analytics_struct *occupancy, uint32_t now_us)
+{
+    uint32_t elapsed_us = occupancy->remainder_us + (now_us - occupancy->last_us);
+    occupancy->last_us = now_us;
+    occupancy->clock_ms += elapsed_us / 1000;
+    occupancy->remainder_us = elapsed_us % 1000;
+}
+
+static void advance_window(struct occupancy_window_struct *window, uint32_t head)
+{
+    if(head == window->head)
+        return;
+
+    if(head - window->head >= OCCUPANCY_BUCKETS)
+    {   // the whole window is expired
+        memset(window->bucket, 0, sizeof(window->bucket));
+        memset(&window->total, 0, sizeof(window->total));
+        window->peak_first = window->peak_num = 0;
+        window->head = head;
+        return;
+    }
+
+    while(window->head != head)
+    {   // the bucket slot reused by the next bucket leaves the window
+        window->head++;
+        uint8_t slot = window->head % OCCUPANCY_BUCKETS;
+        struct occupancy_bucket_struct *expired = &window->bucket[slot];
+        window->total.detections -= expired->detections;
+        window->total.events -= expired->events;
+        window->total.presence_ms -= expired->presence_ms;
+        window->total.visits -= expired->visits;
+        if(window->peak_num > 0 && window->peak_queue[window->peak_first] == slot)
+        {
+            window->peak_first = (window->peak_first + 1) % OCCUPANCY_BUCKETS;
+            window->peak_num--;
+        }
+        memset(expired, 0, sizeof(struct occupancy_bucket_struct));
+    }
+}
+
+static void update_peak(struct occupancy_window_struct *window, uint8_t count)
+{
+    uint8_t slot = window->head % OCCUPANCY_BUCKETS;
+    if(count <= window->bucket[slot].peak)
+        return;
+    window->bucket[slot].peak = count;
+
+    // keep the peaks decreasing from the oldest to the newest bucket, the window peak is the first one
+    while(window->peak_num > 0)
+    {
+        uint8_t last = window->peak_queue[(window->peak_first + window->peak_num - 1) % OCCUPANCY_BUCKETS];
+        if(window->bucket[last].peak > count)
+            break;
+        window->peak_num--;
+    }
+    window->peak_queue[(window->peak_first + window->peak_num) % OCCUPANCY_BUCKETS] = slot;
+    window->peak_num++;
+}
+
+static void update_presence(struct occupancy_analytics_struct *occupancy, struct occupancy_type_struct *type)
+{
+    if(type->present && occupancy->clock_ms - type->last_seen_ms > occupancy->gap_limit_ms)
+        type->present = false;
+}
+
+void occupancy_analytics_tick(struct occupancy_analytics_struct *occupancy, uint32_t now_us)
+{
+    advance_clock(occupancy, now_us);
+}
+
+void occupancy_analytics_feed(struct occupancy_analytics_struct *occupancy, const struct od_data_struct *od_result, uint32_t now_us)
+{
+    uint8_t count[MAX_OD_SUPPORT_TYPES] = { 0 };
+
+    advance_clock(occupancy, now_us);
+    for(uint8_t i = 0; i < od_result->object_num && i < MAX_OD_SUPPORT_OBJECTS; i++)
+    {
+        uint8_t object_type = od_result->object[i].object_type;
+        if(object_type >= OD_OBJECT_TYPE_OFFSET && object_type < OD_OBJECT_TYPE_OFFSET + MAX_OD_SUPPORT_TYPES)
+            count[object_type - OD_OBJECT_TYPE_OFFSET]++;
+    }
+
+    for(uint8_t t = 0; t < MAX_OD_SUPPORT_TYPES; t++)
+    {
+        if(count[t] == 0)
+            continue;
+
+        struct occupancy_type_struct *type = &occupancy->type[t];
+        update_presence(occupancy, type);
+
+        // the time since the previous detection counts as presence if the type did not leave in between
+        uint32_t presence_ms = 0;
+        uint16_t visits = 0;
+        if(type->present)
+            presence_ms = (uint32_t)(occupancy->clock_ms - type->last_seen_ms);
+        else
+        {
+            type->present = true;
+            type->presence_start_ms = occupancy->clock_ms;
+            visits = 1;
+        }
+        type->last_seen_ms = occupancy->clock_ms;
+
+        for(uint8_t w = 0; w < OCCUPANCY_WINDOWS; w++)
+        {
+            struct occupancy_window_struct *window = &type->window[w];
+            advance_window(window, (uint32_t)(occupancy->clock_ms / bucket_ms[w]));
+
+            struct occupancy_bucket_struct *bucket = &window->bucket[window->head % OCCUPANCY_BUCKETS];
+            bucket->detections += count[t];
+            bucket->events++;
+            bucket->presence_ms += presence_ms;
+            bucket->visits += visits;
+            window->total.detections += count[t];
+            window->total.events++;
+            window->total.presence_ms += presence_ms;
+            window->total.visits += visits;
+            update_peak(window, count[t]);
+        }
+    }
+}
+
+void occupancy_analytics_query(struct occupancy_analytics_struct *occupancy, uint8_t type_index, enum OCCUPANCY_WINDOW window,
+    uint32_t now_us, struct occupancy_stats_struct *stats)
+{
+    memset(stats, 0, sizeof(struct occupancy_stats_struct));
+    if(type_index >= MAX_OD_SUPPORT_TYPES || window >= OCCUPANCY_WINDOWS)
+        return;
+
+    advance_clock(occupancy, now_us);
+    struct occupancy_type_struct *type = &occupancy->type[type_index];
+    struct occupancy_window_struct *ring = &type->window[window];
+    advance_window(ring, (uint32_t)(occupancy->clock_ms / bucket_ms[window]));
+    update_presence(occupancy, type);
+
+    stats->detections = ring->total.detections;
+    stats->events = ring->total.events;
+    stats->visits = ring->total.visits;
+    stats->presence_ms = ring->total.presence_ms;
+    stats->average_dwell_ms = stats->visits > 0 ? stats->presence_ms / stats->visits : 0;
+    stats->current_dwell_ms = type->present ? (uint32_t)(occupancy->clock_ms - type->presence_start_ms) : 0;
+    stats->peak_occupancy = ring->peak_num > 0 ? ring->bucket[ring->peak_queue[ring->peak_first]].peak : 0;
+}
@@ -0,0 +1,136 @@
+/** InstAI Co. (Public Version)
+    Description: Streaming per-object-type occupancy analytics over 1-minute, 15-minute and 1-hour sliding windows
+    Modified Date: Oct 19, 2026
+    Remark: each window is a fixed ring of OCCUPANCY_BUCKETS time buckets per object type with running totals,
+        so that an OD result is accounted and a window is queried in constant time without keeping the detections,
+        the windows slide by one bucket (1 s, 15 s and 1 min respectively)
+        the memory used is about MAX_OD_SUPPORT_TYPES * 3 * OCCUPANCY_BUCKETS * 17 bytes (~65 KB),
+        reduce OCCUPANCY_BUCKETS on small hosts to trade the sliding granularity for memory
+*/
+
+#ifndef OCCUPANCY_ANALYTICS_H
+#define OCCUPANCY_ANALYTICS_H
+
+#include "ai_module.h"
+
+//-- Constant values
+#define OCCUPANCY_BUCKETS   60      // time buckets per window (at most 255)
+
+//-- Enumerations
+/**
+    @brief: sliding windows of the analytics
+*/
+enum OCCUPANCY_WINDOW
+{
+    OCCUPANCY_WINDOW_1_MINUTE = 0,
+    OCCUPANCY_WINDOW_15_MINUTES,
+    OCCUPANCY_WINDOW_1_HOUR,
+    OCCUPANCY_WINDOWS
+};
+
+//-- Structures
+/**
+    @brief: aggregated values of a time bucket, also used for the running totals of a window
+*/
+struct occupancy_bucket_struct {
+    uint32_t detections;            // objects of the type detected
+    uint32_t events;                // OD results containing the type
+    uint32_t presence_ms;           // time the type was continuously present
+    uint16_t visits;                // presence periods started
+    uint8_t peak;                   // maximum number of objects of the type in a single OD result
+};
+
+/**
+    @brief: ring of buckets of a window
+*/
+struct occupancy_window_struct {
+    uint32_t head;                                          // number of the current bucket since initialization
+    struct occupancy_bucket_struct bucket[OCCUPANCY_BUCKETS];
+    struct occupancy_bucket_struct total;                   // running totals of the buckets (peak unused)
+    uint8_t peak_queue[OCCUPANCY_BUCKETS];                  // buckets with decreasing peak, oldest first
+    uint8_t peak_first, peak_num;
+};
+
+/**
+    @brief: state of an object type
+*/
+struct occupancy_type_struct {
+    bool present;
+    uint64_t last_seen_ms;
+    uint64_t presence_start_ms;
+    struct occupancy_window_struct window[OCCUPANCY_WINDOWS];
+};
+
+/**
+    @brief: state of the occupancy analytics
+*/
+struct occupancy_analytics_struct {
+    uint32_t gap_limit_ms;          // an object type not detected for longer than this is considered gone
+    uint64_t clock_ms;              // time elapsed since initialization
+    uint32_t last_us;
+    uint32_t remainder_us;
+    struct occupancy_type_struct type[MAX_OD_SUPPORT_TYPES];
+};
+
+/**
+    @brief: results of a window query
+*/
+struct occupancy_stats_struct {
+    uint32_t detections;            // objects of the type detected in the window
+    uint32_t events;                // OD results containing the type in the window
+    uint32_t visits;                // presence periods started in the window (arrivals)
+    uint32_t presence_ms;           // time the type was present in the window
+    uint32_t average_dwell_ms;      // presence time per visit
+    uint32_t current_dwell_ms;      // duration of the ongoing presence, 0 if the type is absent
+    uint8_t peak_occupancy;         // maximum number of objects of the type in a single OD result
+};
+
+/**
+    @brief: initialize the occupancy analytics
+    @parameter:
+        occupancy:      the analytics to initialize
+        gap_limit_ms:   an object type not detected for longer than this ends its presence (e.g. 5000)
+        now_us:         current time given by interface_micros()
+    @return:
+        (NONE)
+*/
+void occupancy_analytics_init(struct occupancy_analytics_struct *occupancy, uint32_t gap_limit_ms, uint32_t now_us);
+
+/**
+    @brief: account the OD result of an event
+    @parameter:
+        occupancy:  the occupancy analytics
+        od_result:  OD result retrieved by ai_module_process_event()
+        now_us:     current time given by interface_micros()
+    @return:
+        (NONE)
+*/
+void occupancy_analytics_feed(struct occupancy_analytics_struct *occupancy, const struct od_data_struct *od_result, uint32_t now_us);
+
+/**
+    @brief: advance the clock of the analytics
+    @parameter:
+        occupancy:  the occupancy analytics
+        now_us:     current time given by interface_micros()
+    @return:
+        (NONE)
+    @remark: interface_micros() wraps around every ~71 minutes, call it from the main loop so that
+        the analytics see the time elapsing while no OD result is fed
+*/
+void occupancy_analytics_tick(struct occupancy_analytics_struct *occupancy, uint32_t now_us);
+
+/**
+    @brief: get the analytics of an object type over a window
+    @parameter:
+        occupancy:  the occupancy analytics
+        type_index: index of the object type (object_type - OD_OBJECT_TYPE_OFFSET)
+        window:     one of the windows defined in enumeration OCCUPANCY_WINDOW
+        now_us:     current time given by interface_micros()
+        stats:      give the variable with type "occupancy_stats_struct" to store the results
+    @return:
+        (NONE)
+*/
+void occupancy_analytics_query(struct occupancy_analytics_struct *occupancy, uint8_t type_index, enum OCCUPANCY_WINDOW window,
+    uint32_t now_us, struct occupancy_stats_struct *stats);
+
+#endif // OCCUPANCY_ANALYTICS_H
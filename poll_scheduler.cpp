@@ -0,0 +1,137 @@
+/** InstAI Co. (Public Version)
+    Description: Adaptive event polling interval for the AI module main loop
+    Modified Date: Oct 19, 2026
+*/
+#include "poll_scheduler.h"
+
+/* ---- internal function prototypes declaration ---- */
+static const struct poll_scheduler_bound_struct *get_mode_bound(const struct poll_scheduler_struct *scheduler, enum AI_MODULE_MODE mode);
+
+void poll_scheduler_default_config(struct poll_scheduler_config_struct *config)
+{
+    memset(config, 0, sizeof(struct poll_scheduler_config_struct));
+
+    // NPU is always on, OD events could come at any time
+    config->od_mode.min_interval_us = 10000;
+    config->od_mode.max_interval_us = 50000;
+    config->od_jpeg_mode.min_interval_us = 10000;
+    config->od_jpeg_mode.max_interval_us = 50000;
+
+    // NPU is powered down in sensor motion state and needs time to wake up before the first OD event,
+    // so quiet periods back off further; right after an event NPU is awake and polled as fast as in OD modes
+    config->s_motion_od_mode.min_interval_us = 10000;
+    config->s_motion_od_mode.max_interval_us = 200000;
+    config->s_motion_od_jpeg_mode.min_interval_us = 10000;
+    config->s_motion_od_jpeg_mode.max_interval_us = 200000;
+
+    config->idle_interval_us = 50000;
+    config->hold_polls = 10;
+    config->backoff_percent = 50;
+    config->gap_divider = 4;
+}
+
+void poll_scheduler_init(struct poll_scheduler_struct *scheduler, const struct poll_scheduler_config_struct *config)
+{
+    memset(scheduler, 0, sizeof(struct poll_scheduler_struct));
+
+    if(config != NULL)
+        memcpy(&scheduler->config, config, sizeof(struct poll_scheduler_config_struct));
+    else
+        poll_scheduler_default_config(&scheduler->config);
+
+    scheduler->mode = IDLE_MODE;
+    scheduler->interval_us = scheduler->config.idle_interval_us;
+}
+
+static const struct poll_scheduler_bound_struct *get_mode_bound(const struct poll_scheduler_struct *scheduler, enum AI_MODULE_MODE mode)
+{
+    switch (mode)
+    {
+        case OD_MODE:
+            return &scheduler->config.od_mode;
+        case S_MOTION_OD_MODE:
+            return &scheduler->config.s_motion_od_mode;
+        case OD_JPEG_MODE:
+            return &scheduler->config.od_jpeg_mode;
+        case S_MOTION_OD_JPEG_MODE:
+            return &scheduler->config.s_motion_od_jpeg_mode;
+        default:
+            return NULL;
+    }
+}
+
+uint32_t poll_scheduler_update(struct poll_scheduler_struct *scheduler, enum AI_MODULE_MODE mode, bool event_detected)
+{
+    const struct poll_scheduler_bound_struct *bound = get_mode_bound(scheduler, mode);
+
+    scheduler->polls++;
+    scheduler->since_event_us += scheduler->interval_us;
+
+    if(bound == NULL)
+    {   // IDLE_MODE (or unknown mode), AI module does not report any event
+        scheduler->mode = mode;
+        scheduler->interval_us = scheduler->config.idle_interval_us;
+        return scheduler->interval_us;
+    }
+
+    if(mode != scheduler->mode)
+    {   // keep the first detection latency low after switching mode, event history belongs to the previous mode
+        scheduler->mode = mode;
+        scheduler->quiet_polls = 0;
+        scheduler->since_event_us = 0;
+        scheduler->event_gap_avg_us = 0;
+        scheduler->interval_us = bound->min_interval_us;
+        if(!event_detected)
+            return scheduler->interval_us;
+    }
+
+    if(event_detected)
+    {
+        scheduler->events++;
+        if(scheduler->event_gap_avg_us == 0)
+            scheduler->event_gap_avg_us = scheduler->since_event_us;
+        else    // moving average with weight 1/8 for the latest gap
+            scheduler->event_gap_avg_us = scheduler->event_gap_avg_us - (scheduler->event_gap_avg_us >> 3) + (scheduler->since_event_us >> 3);
+
+        scheduler->quiet_polls = 0;
+        scheduler->since_event_us = 0;
+        scheduler->interval_us = bound->min_interval_us;
+        return scheduler->interval_us;
+    }
+
+    scheduler->quiet_polls++;
+    if(scheduler->quiet_polls <= scheduler->config.hold_polls)
+        return scheduler->interval_us;
+
+    // exponential back-off during quiet periods
+    uint32_t ceiling = bound->max_interval_us;
+    if(scheduler->event_gap_avg_us != 0 && scheduler->config.gap_divider != 0 &&
+        scheduler->since_event_us < 2 * scheduler->event_gap_avg_us)
+    {   // events are still expected soon, do not back off further than a fraction of the usual event gap
+        uint32_t gap_ceiling = scheduler->event_gap_avg_us / scheduler->config.gap_divider;
+        if(gap_ceiling < ceiling)
+            ceiling = gap_ceiling;
+    }
+
+    uint32_t interval = scheduler->interval_us + (uint32_t)(((uint64_t)scheduler->interval_us * scheduler->config.backoff_percent) / 100);
+    if(interval > ceiling)
+        interval = ceiling;
+    if(interval < bound->min_interval_us)
+        interval = bound->min_interval_us;
+
+    scheduler->interval_us = interval;
+    return scheduler->interval_us;
+}
+
+uint32_t poll_scheduler_get_interval(const struct poll_scheduler_struct *scheduler)
+{
+    return scheduler->interval_us;
+}
+
+void poll_scheduler_get_stats(const struct poll_scheduler_struct *scheduler, struct poll_scheduler_stats_struct *stats)
+{
+    stats->interval_us = scheduler->interval_us;
+    stats->event_gap_avg_us = scheduler->event_gap_avg_us;
+    stats->polls = scheduler->polls;
+    stats->events = scheduler->events;
+}
@@ -0,0 +1,114 @@
+/** InstAI Co. (Public Version)
+    Description: Adaptive event polling interval for the AI module main loop
+    Modified Date: Oct 19, 2026
+    Remark: the polling interval is tightened right after an OD event and backed off exponentially
+        during quiet periods, bounded by the latency limits configured for each AI_MODULE_MODE
+*/
+
+#ifndef POLL_SCHEDULER_H
+#define POLL_SCHEDULER_H
+
+#include "ai_module.h"
+
+//-- Structures
+/**
+    @brief: polling interval bounds of one AI module mode
+    @remark: min_interval_us is used right after an event, max_interval_us is the worst-case detection latency
+        added by polling during quiet periods
+*/
+struct poll_scheduler_bound_struct {
+    uint32_t min_interval_us;
+    uint32_t max_interval_us;
+};
+
+/**
+    @brief: settings of the polling scheduler
+    @remark: call poll_scheduler_default_config() to fill the recommended values before customizing the settings
+*/
+struct poll_scheduler_config_struct {
+    struct poll_scheduler_bound_struct od_mode;
+    struct poll_scheduler_bound_struct s_motion_od_mode;
+    struct poll_scheduler_bound_struct od_jpeg_mode;
+    struct poll_scheduler_bound_struct s_motion_od_jpeg_mode;
+    uint32_t idle_interval_us;      // interval used in IDLE_MODE, only the user inputs are served
+    uint16_t hold_polls;            // number of quiet polls kept at min_interval_us after an event
+    uint16_t backoff_percent;       // growth of the interval per quiet poll, 50 means x1.5
+    uint16_t gap_divider;           // during steady event streams, poll at least (average event gap / gap_divider)
+};
+
+/**
+    @brief: state of the polling scheduler
+    @remark: read the fields through poll_scheduler_get_interval() / poll_scheduler_get_stats()
+*/
+struct poll_scheduler_struct {
+    struct poll_scheduler_config_struct config;
+    enum AI_MODULE_MODE mode;
+    uint32_t interval_us;           // currently chosen polling interval
+    uint32_t quiet_polls;           // polls without event since the last event
+    uint32_t since_event_us;        // scheduled time elapsed since the last event
+    uint32_t event_gap_avg_us;      // moving average of the time between events, 0 if unknown
+    uint32_t polls;                 // total number of polls
+    uint32_t events;                // total number of polls returning an event
+};
+
+/**
+    @brief: statistics of the polling scheduler
+*/
+struct poll_scheduler_stats_struct {
+    uint32_t interval_us;           // currently chosen polling interval
+    uint32_t event_gap_avg_us;      // moving average of the time between events, 0 if unknown
+    uint32_t polls;
+    uint32_t events;
+};
+
+/**
+    @brief: fill the recommended settings of the polling scheduler
+    @parameter:
+        config: give the variable with type "poll_scheduler_config_struct" to store the settings
+    @return:
+        (NONE)
+*/
+void poll_scheduler_default_config(struct poll_scheduler_config_struct *config);
+
+/**
+    @brief: initialize the polling scheduler
+    @parameter:
+        scheduler:  the scheduler to initialize
+        config:     settings of the scheduler, or NULL to use the recommended settings
+    @return:
+        (NONE)
+*/
+void poll_scheduler_init(struct poll_scheduler_struct *scheduler, const struct poll_scheduler_config_struct *config);
+
+/**
+    @brief: report the result of a poll and get the interval to wait before the next poll
+    @parameter:
+        scheduler:      the polling scheduler
+        mode:           current mode of AI module
+        event_detected: true if the poll returned an event (e.g. ai_module_process_event() returned true)
+    @return:
+        polling interval in microseconds
+    @remark: the interval is reset to the minimum of the new mode when the mode changes
+*/
+uint32_t poll_scheduler_update(struct poll_scheduler_struct *scheduler, enum AI_MODULE_MODE mode, bool event_detected);
+
+/**
+    @brief: get the currently chosen polling interval
+    @parameter:
+        scheduler: the polling scheduler
+    @return:
+        polling interval in microseconds
+*/
+uint32_t poll_scheduler_get_interval(const struct poll_scheduler_struct *scheduler);
+
+/**
+    @brief: get the statistics of the polling scheduler
+    @parameter:
+        scheduler:  the polling scheduler
+        stats:      give the variable with type "poll_scheduler_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void poll_scheduler_get_stats(const struct poll_scheduler_struct *scheduler, struct poll_scheduler_stats_struct *stats);
+
+#endif // POLL_SCHEDULER_H
@@ -0,0 +1,401 @@
+/** InstAI Co. (Public Version)
+    Description: Real-time event servicing thread with bounded wake-up jitter
+    Modified Date: Oct 19, 2026
+*/
+#include "rt_loop.h"
+
+#ifdef PLATFORM_POSIX
+#include <pthread.h>
+#include <sched.h>
+#include <malloc.h>
+#include <alloca.h>
+#include <sys/mman.h>
+
+//-- Constant values
+#define NSEC_PER_SEC 1000000000L
+#define PAGE_STEP 4096
+
+/* ---- internal function prototypes declaration ---- */
+static void *rt_thread(void *arg);
+static void prefault_stack(uint32_t size);
+static uint64_t now_ns();
+static void wait_until(const struct timespec *deadline);
+static void add_ns(struct timespec *time, uint64_t ns);
+static int64_t diff_ns(const struct timespec *a, const struct timespec *b);
+static uint32_t histogram_bucket(uint32_t duration_us);
+static void serve_request();
+static void switch_mode_request(void *arg);
+
+//-- Global variables
+static struct rt_loop_config_struct rt_config;
+static FunPtr_RtLoopEvent rt_event_func = NULL;
+static pthread_t rt_thread_id;
+static bool rt_running = false;     // accessed with atomic operations
+static uint8_t rt_mode = IDLE_MODE;
+
+// statistics written by the real-time thread only, read under a sequence lock
+static struct rt_loop_stats_struct rt_stats;
+static uint32_t rt_stats_seq = 0;
+
+// single-producer (real-time thread) single-consumer (application) queue of OD results
+static struct od_data_struct od_queue[RT_LOOP_QUEUE_SIZE];
+static uint32_t od_queue_head = 0, od_queue_tail = 0;
+
+// single-producer (real-time thread) single-consumer (application) queue of JPEGs
+static struct rt_loop_jpeg_struct jpeg_queue[RT_LOOP_JPEG_QUEUE_SIZE];
+static uint32_t jpeg_queue_head = 0, jpeg_queue_tail = 0;
+static uint64_t jpeg_dropped = 0;
+
+// request executed on the real-time thread, callers are serialized by request_lock
+static pthread_mutex_t request_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t request_done_lock;
+static pthread_cond_t request_done_cond = PTHREAD_COND_INITIALIZER;
+static FunPtr_RtLoopRequest request_func = NULL;
+static void *request_arg = NULL;
+static uint32_t request_pending = 0;
+
+void rt_loop_default_config(struct rt_loop_config_struct *config)
+{
+    memset(config, 0, sizeof(struct rt_loop_config_struct));
+    config->period_us = 1000;
+    config->priority = 80;
+    config->cpu = -1;
+    config->wait = RT_LOOP_WAIT_SLEEP;
+    config->lock_memory = true;
+    config->prefault_stack_size = 64 * 1024;
+}
+
+bool rt_loop_start(const struct rt_loop_config_struct *config, FunPtr_RtLoopEvent event_func)
+{
+    if(__atomic_load_n(&rt_running, __ATOMIC_ACQUIRE))
+        return false;
+
+    if(config != NULL)
+        memcpy(&rt_config, config, sizeof(struct rt_loop_config_struct));
+    else
+        rt_loop_default_config(&rt_config);
+    if(rt_config.period_us == 0)
+        rt_config.period_us = 1;
+    rt_event_func = event_func;
+
+    memset(&rt_stats, 0, sizeof(rt_stats));
+    od_queue_head = od_queue_tail = 0;
+    jpeg_queue_head = jpeg_queue_tail = 0;
+    jpeg_dropped = 0;
+    __atomic_store_n(&rt_mode, (uint8_t)ai_module_get_mode(), __ATOMIC_RELAXED);
+
+    // the waker of a blocked request caller must not be delayed by a lower priority thread
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&request_done_lock, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    if(rt_config.lock_memory)
+    {   // locking faults in every mapped page (including the SPI data buffer), keep the heap from shrinking or using mmap
+        rt_stats.memory_locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if(rt_config.priority > 0)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = rt_config.priority;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+    if(rt_config.cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(rt_config.cpu, &cpus);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+    }
+
+    __atomic_store_n(&rt_running, true, __ATOMIC_RELEASE);
+    int result = pthread_create(&rt_thread_id, &attr, rt_thread, NULL);
+    if(result != 0)
+    {   // not permitted to use real-time scheduling or this CPU, run with the normal policy
+        pthread_attr_destroy(&attr);
+        pthread_attr_init(&attr);
+        result = pthread_create(&rt_thread_id, &attr, rt_thread, NULL);
+    }
+    pthread_attr_destroy(&attr);
+
+    if(result != 0)
+    {
+        __atomic_store_n(&rt_running, false, __ATOMIC_RELEASE);
+        return false;
+    }
+    return true;
+}
+
+void rt_loop_stop()
+{
+    if(!__atomic_load_n(&rt_running, __ATOMIC_ACQUIRE))
+        return;
+
+    __atomic_store_n(&rt_running, false, __ATOMIC_RELEASE);
+    pthread_join(rt_thread_id, NULL);
+    pthread_mutex_destroy(&request_done_lock);
+}
+
+bool rt_loop_pop_od(struct od_data_struct *od_result)
+{
+    uint32_t tail = od_queue_tail;
+    if(tail == __atomic_load_n(&od_queue_head, __ATOMIC_ACQUIRE))
+        return false;
+
+    memcpy(od_result, &od_queue[tail % RT_LOOP_QUEUE_SIZE], sizeof(struct od_data_struct));
+    __atomic_store_n(&od_queue_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void rt_loop_queue_jpeg(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_struct *od_result)
+{
+    uint32_t head = jpeg_queue_head;
+    if(head - __atomic_load_n(&jpeg_queue_tail, __ATOMIC_ACQUIRE) >= RT_LOOP_JPEG_QUEUE_SIZE || jpeg_size > AI_MODULE_BUFFER_SIZE)
+    {
+        jpeg_dropped++;
+        return;
+    }
+
+    // the file output and the publication of the JPEG are left to the application
+    struct rt_loop_jpeg_struct *jpeg = &jpeg_queue[head % RT_LOOP_JPEG_QUEUE_SIZE];
+    memcpy(jpeg->data, jpeg_data, jpeg_size);
+    jpeg->size = (uint32_t)jpeg_size;
+    jpeg->has_od_result = od_result != NULL;
+    if(od_result != NULL)
+        memcpy(&jpeg->od_result, od_result, sizeof(struct od_data_struct));
+    jpeg->jpeg_frame = ai_module_get_jpeg_frame();
+    __atomic_store_n(&jpeg_queue_head, head + 1, __ATOMIC_RELEASE);
+}
+
+const struct rt_loop_jpeg_struct *rt_loop_peek_jpeg()
+{
+    uint32_t tail = jpeg_queue_tail;
+    if(tail == __atomic_load_n(&jpeg_queue_head, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &jpeg_queue[tail % RT_LOOP_JPEG_QUEUE_SIZE];
+}
+
+void rt_loop_release_jpeg()
+{
+    if(jpeg_queue_tail != __atomic_load_n(&jpeg_queue_head, __ATOMIC_ACQUIRE))
+        __atomic_store_n(&jpeg_queue_tail, jpeg_queue_tail + 1, __ATOMIC_RELEASE);
+}
+
+void rt_loop_execute(FunPtr_RtLoopRequest func, void *arg)
+{
+    if(!__atomic_load_n(&rt_running, __ATOMIC_ACQUIRE))
+    {
+        func(arg);
+        return;
+    }
+
+    pthread_mutex_lock(&request_lock);
+    pthread_mutex_lock(&request_done_lock);
+    request_func = func;
+    request_arg = arg;
+    __atomic_store_n(&request_pending, 1, __ATOMIC_RELEASE);
+    while(__atomic_load_n(&request_pending, __ATOMIC_ACQUIRE) != 0)
+        pthread_cond_wait(&request_done_cond, &request_done_lock);
+    pthread_mutex_unlock(&request_done_lock);
+    pthread_mutex_unlock(&request_lock);
+}
+
+static void switch_mode_request(void *arg)
+{
+    ai_module_switch_mode(*(enum AI_MODULE_MODE *)arg);
+}
+
+void rt_loop_switch_mode(enum AI_MODULE_MODE mode)
+{
+    rt_loop_execute(switch_mode_request, &mode);
+}
+
+enum AI_MODULE_MODE rt_loop_get_mode()
+{
+    return (enum AI_MODULE_MODE)__atomic_load_n(&rt_mode, __ATOMIC_RELAXED);
+}
+
+void rt_loop_get_stats(struct rt_loop_stats_struct *stats)
+{
+    uint32_t seq;
+    do {
+        while((seq = __atomic_load_n(&rt_stats_seq, __ATOMIC_ACQUIRE)) & 1);
+        memcpy(stats, &rt_stats, sizeof(struct rt_loop_stats_struct));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while(__atomic_load_n(&rt_stats_seq, __ATOMIC_RELAXED) != seq);
+}
+
+uint32_t rt_loop_histogram_percentile(const uint32_t *histogram, double percent)
+{
+    uint64_t total = 0, count = 0;
+    for(uint8_t b = 0; b < RT_LOOP_HISTOGRAM_BUCKETS; b++)
+        total += histogram[b];
+    if(total == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t)(total * percent / 100.0);
+    for(uint8_t b = 0; b < RT_LOOP_HISTOGRAM_BUCKETS; b++)
+    {
+        count += histogram[b];
+        if(count > rank)
+            return 1U << b;
+    }
+    return 1U << (RT_LOOP_HISTOGRAM_BUCKETS - 1);
+}
+
+static uint32_t histogram_bucket(uint32_t duration_us)
+{
+    uint32_t bucket = duration_us == 0 ? 0 : 32 - __builtin_clz(duration_us);
+    return bucket < RT_LOOP_HISTOGRAM_BUCKETS ? bucket : RT_LOOP_HISTOGRAM_BUCKETS - 1;
+}
+
+static void prefault_stack(uint32_t size)
+{
+    volatile uint8_t *stack = (volatile uint8_t *)alloca(size);
+    for(uint32_t i = 0; i < size; i += PAGE_STEP)
+        stack[i] = 0;
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void add_ns(struct timespec *time, uint64_t ns)
+{
+    time->tv_sec += ns / NSEC_PER_SEC;
+    time->tv_nsec += ns % NSEC_PER_SEC;
+    if(time->tv_nsec >= NSEC_PER_SEC)
+    {
+        time->tv_sec++;
+        time->tv_nsec -= NSEC_PER_SEC;
+    }
+}
+
+static int64_t diff_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (int64_t)(a->tv_sec - b->tv_sec) * NSEC_PER_SEC + (a->tv_nsec - b->tv_nsec);
+}
+
+static void wait_until(const struct timespec *deadline)
+{
+    if(rt_config.wait == RT_LOOP_WAIT_BUSY_POLL)
+    {
+        struct timespec now;
+        do {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } while(diff_ns(&now, deadline) < 0);
+        return;
+    }
+
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL) == EINTR);
+}
+
+static void serve_request()
+{
+    if(__atomic_load_n(&request_pending, __ATOMIC_ACQUIRE) == 0)
+        return;
+
+    request_func(request_arg);
+    __atomic_store_n(&rt_mode, (uint8_t)ai_module_get_mode(), __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&request_done_lock);
+    __atomic_store_n(&request_pending, 0, __ATOMIC_RELEASE);
+    pthread_cond_signal(&request_done_cond);
+    pthread_mutex_unlock(&request_done_lock);
+}
+
+static void *rt_thread(void *arg)
+{
+    (void)arg;
+
+    int policy;
+    struct sched_param param;
+    cpu_set_t cpus;
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    rt_stats.realtime = (policy == SCHED_FIFO);
+    rt_stats.affinity = rt_config.cpu >= 0 && pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0 &&
+        CPU_COUNT(&cpus) == 1 && CPU_ISSET(rt_config.cpu, &cpus);
+    prefault_stack(rt_config.prefault_stack_size);
+
+    uint64_t period_ns = (uint64_t)rt_config.period_us * 1000;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    while(__atomic_load_n(&rt_running, __ATOMIC_ACQUIRE))
+    {
+        add_ns(&deadline, period_ns);
+        wait_until(&deadline);
+
+        struct timespec woke;
+        clock_gettime(CLOCK_MONOTONIC, &woke);
+        int64_t late_ns = diff_ns(&woke, &deadline);
+        uint32_t wakeup_us = late_ns > 0 ? (uint32_t)(late_ns / 1000) : 0;
+
+        serve_request();
+
+        bool is_obj_detected = false;
+        uint32_t service_us = 0;
+        struct od_data_struct *od_result = &od_queue[od_queue_head % RT_LOOP_QUEUE_SIZE];
+        bool queue_full = od_queue_head - __atomic_load_n(&od_queue_tail, __ATOMIC_ACQUIRE) >= RT_LOOP_QUEUE_SIZE;
+        if(rt_mode != IDLE_MODE)
+        {
+            struct od_data_struct overflow;
+            uint64_t service_start_ns = now_ns();
+            is_obj_detected = ai_module_process_event(queue_full ? &overflow : od_result);
+            if(is_obj_detected && rt_event_func != NULL)
+                rt_event_func(queue_full ? &overflow : od_result);
+            service_us = (uint32_t)((now_ns() - service_start_ns) / 1000);
+        }
+
+        __atomic_store_n(&rt_stats_seq, rt_stats_seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        rt_stats.cycles++;
+        rt_stats.wakeup_histogram[histogram_bucket(wakeup_us)]++;
+        if(wakeup_us > rt_stats.wakeup_max_us)
+            rt_stats.wakeup_max_us = wakeup_us;
+        if(rt_mode != IDLE_MODE)
+        {
+            rt_stats.service_histogram[histogram_bucket(service_us)]++;
+            if(service_us > rt_stats.service_max_us)
+                rt_stats.service_max_us = service_us;
+        }
+        if(is_obj_detected)
+        {
+            rt_stats.events++;
+            if(wakeup_us + service_us > rt_stats.response_max_us)
+                rt_stats.response_max_us = wakeup_us + service_us;
+            if(queue_full)
+                rt_stats.queue_dropped++;
+        }
+        rt_stats.jpeg_dropped = jpeg_dropped;
+
+        // skip the deadlines already missed instead of running late cycles back to back
+        clock_gettime(CLOCK_MONOTONIC, &woke);
+        int64_t behind_ns = diff_ns(&woke, &deadline);
+        if(behind_ns > (int64_t)period_ns)
+        {
+            uint64_t missed = (uint64_t)behind_ns / period_ns;
+            rt_stats.overruns += missed;
+            add_ns(&deadline, missed * period_ns);
+        }
+        __atomic_store_n(&rt_stats_seq, rt_stats_seq + 1, __ATOMIC_RELEASE);
+
+        if(is_obj_detected && !queue_full)
+            __atomic_store_n(&od_queue_head, od_queue_head + 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+#endif // PLATFORM_POSIX
@@ -0,0 +1,221 @@
+/** InstAI Co. (Public Version)
+    Description: Real-time event servicing thread with bounded wake-up jitter
+    Modified Date: Oct 19, 2026
+    Remark: requires a POSIX platform (Linux), the AI module is polled by a dedicated thread with SCHED_FIFO priority,
+        CPU affinity, locked and prefaulted memory and absolute deadlines (clock_nanosleep) or busy polling,
+        once started the AI module must only be accessed from this thread: OD results and JPEGs are queued for the
+        application, and mode switches or other AI module accesses are executed on the thread with rt_loop_execute()
+*/
+
+#ifndef RT_LOOP_H
+#define RT_LOOP_H
+
+#include "ai_module.h"
+
+#ifdef PLATFORM_POSIX
+
+//-- Constant values
+#define RT_LOOP_QUEUE_SIZE          32      // OD results waiting for rt_loop_pop_od()
+#define RT_LOOP_JPEG_QUEUE_SIZE     8       // JPEGs waiting for rt_loop_peek_jpeg()
+#define RT_LOOP_HISTOGRAM_BUCKETS   24      // bucket n counts durations below 2^n us, the last one counts the longer ones
+
+//-- Enumerations
+/**
+    @brief: how the thread waits for the next polling deadline
+    @remark: RT_LOOP_WAIT_BUSY_POLL has the lowest jitter but keeps its CPU fully busy, use it with a dedicated CPU
+*/
+enum RT_LOOP_WAIT
+{
+    RT_LOOP_WAIT_SLEEP = 0,
+    RT_LOOP_WAIT_BUSY_POLL
+};
+
+//-- Structures
+/**
+    @brief: settings of the real-time thread
+    @remark: call rt_loop_default_config() to fill the recommended values before customizing the settings
+*/
+struct rt_loop_config_struct {
+    uint32_t period_us;             // polling period, the worst-case response time is period + wake-up latency + service time
+    int32_t priority;               // SCHED_FIFO priority (1 ~ 99), 0 = keep the normal scheduling policy
+    int32_t cpu;                    // CPU the thread is pinned on, -1 = no affinity
+    enum RT_LOOP_WAIT wait;
+    bool lock_memory;               // lock all current and future pages of the process in RAM
+    uint32_t prefault_stack_size;   // bytes of thread stack touched before the first cycle
+};
+
+/**
+    @brief: statistics of the real-time thread
+    @remark: wake-up latency is the delay between the deadline and the thread running,
+        service time is the duration of ai_module_process_event(), response time is their sum for cycles with an OD result
+*/
+struct rt_loop_stats_struct {
+    bool realtime;                  // SCHED_FIFO priority granted
+    bool affinity;                  // thread pinned on the configured CPU
+    bool memory_locked;
+    uint64_t cycles;
+    uint64_t overruns;              // missed deadlines (the thread skips to the next one)
+    uint64_t events;                // OD results
+    uint64_t queue_dropped;         // OD results lost because the application did not pop them in time
+    uint64_t jpeg_dropped;          // JPEGs lost because the application did not save them in time
+    uint32_t wakeup_histogram[RT_LOOP_HISTOGRAM_BUCKETS];
+    uint32_t service_histogram[RT_LOOP_HISTOGRAM_BUCKETS];
+    uint32_t wakeup_max_us;
+    uint32_t service_max_us;
+    uint32_t response_max_us;
+};
+
+/**
+    @brief: a JPEG queued by rt_loop_queue_jpeg()
+*/
+struct rt_loop_jpeg_struct {
+    uint8_t data[AI_MODULE_BUFFER_SIZE];
+    uint32_t size;
+    bool has_od_result;             // the JPEG came with an OD result
+    struct od_data_struct od_result;
+    enum AI_MODULE_JPEG_FRAME jpeg_frame;   // frame given by ai_module_get_jpeg_frame()
+};
+
+//-- Function Pointer
+/**
+    @brief: function pointer which points to custom function reacting to an OD result on the real-time thread
+    @parameter:
+        od_result: OD result retrieved by ai_module_process_event()
+    @remark: the function runs within the bounded response time, it must not block (no file or console output)
+*/
+typedef void (*FunPtr_RtLoopEvent)(const struct od_data_struct *od_result);
+
+/**
+    @brief: function pointer which points to custom function executed on the real-time thread by rt_loop_execute()
+    @parameter:
+        arg: argument given to rt_loop_execute()
+*/
+typedef void (*FunPtr_RtLoopRequest)(void *arg);
+
+/**
+    @brief: fill the recommended settings
+    @parameter:
+        config: give the variable with type "rt_loop_config_struct" to store the settings
+    @return:
+        (NONE)
+    @remark: 1 ms period, priority 80, no affinity, sleeping until absolute deadlines, memory locked, 64 KB stack prefaulted
+*/
+void rt_loop_default_config(struct rt_loop_config_struct *config);
+
+/**
+    @brief: start polling AI module on the real-time thread
+    @parameter:
+        config:     settings of the thread, or NULL to use the recommended settings
+        event_func: function called on the real-time thread for each OD result, or NULL
+    @return:
+        return true if the thread is started
+        otherwise, return false
+    @remark: call it once AI module is initialized and configured, real-time priority and memory locking need
+        CAP_SYS_NICE and CAP_IPC_LOCK (or root), the thread still runs without them, see rt_loop_get_stats()
+        the JPEG saving function registered with ai_module_register_save_jpeg_func() is also called on this thread,
+        register rt_loop_queue_jpeg() so that the JPEGs are saved by the application instead
+*/
+bool rt_loop_start(const struct rt_loop_config_struct *config, FunPtr_RtLoopEvent event_func);
+
+/**
+    @brief: stop the real-time thread
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+*/
+void rt_loop_stop();
+
+/**
+    @brief: get the next queued OD result
+    @parameter:
+        od_result: give the variable with type "od_data_struct" to store the OD result
+    @return:
+        return true if an OD result is retrieved
+        otherwise, return false
+    @remark: replaces ai_module_process_event() in the application main loop while the thread runs
+*/
+bool rt_loop_pop_od(struct od_data_struct *od_result);
+
+/**
+    @brief: save JPEG function copying the JPEG and its OD result into the queue of the application
+    @parameter:
+        jpeg_data, jpeg_size, od_result: given by AI module
+    @return:
+        (NONE)
+    @remark: register it with ai_module_register_save_jpeg_func() before rt_loop_start(), it only copies the JPEG
+        on the real-time thread, the JPEG is dropped if the queue is full or the JPEG is larger than AI_MODULE_BUFFER_SIZE
+*/
+void rt_loop_queue_jpeg(uint8_t *jpeg_data, size_t jpeg_size, struct od_data_struct *od_result);
+
+/**
+    @brief: get the next queued JPEG in place
+    @parameter:
+        (NONE)
+    @return:
+        the oldest queued JPEG, or NULL if the queue is empty
+    @remark: call rt_loop_release_jpeg() once the JPEG is saved
+*/
+const struct rt_loop_jpeg_struct *rt_loop_peek_jpeg();
+
+/**
+    @brief: free the JPEG returned by rt_loop_peek_jpeg() for the real-time thread
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+*/
+void rt_loop_release_jpeg();
+
+/**
+    @brief: execute a function accessing AI module on the real-time thread
+    @parameter:
+        func:   the function to execute
+        arg:    argument given to the function
+    @return:
+        (NONE)
+    @remark: blocks the caller until the function has been executed (at most one polling period plus its duration),
+        executes the function directly if the thread is not running
+*/
+void rt_loop_execute(FunPtr_RtLoopRequest func, void *arg);
+
+/**
+    @brief: switch the mode of AI module from the real-time thread
+    @parameter:
+        mode: one of the modes defined in enumeration AI_MODULE_MODE
+    @return:
+        (NONE)
+*/
+void rt_loop_switch_mode(enum AI_MODULE_MODE mode);
+
+/**
+    @brief: get the mode of AI module last read by the real-time thread
+    @parameter:
+        (NONE)
+    @return:
+        current mode of AI module defined in enumeration AI_MODULE_MODE
+*/
+enum AI_MODULE_MODE rt_loop_get_mode();
+
+/**
+    @brief: get the statistics (jitter report) of the real-time thread
+    @parameter:
+        stats: give the variable with type "rt_loop_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void rt_loop_get_stats(struct rt_loop_stats_struct *stats);
+
+/**
+    @brief: get a percentile of a histogram of the statistics
+    @parameter:
+        histogram:  wakeup_histogram or service_histogram
+        percent:    percentile to compute (e.g. 99.9)
+    @return:
+        upper bound of the percentile in microseconds
+*/
+uint32_t rt_loop_histogram_percentile(const uint32_t *histogram, double percent);
+
+#endif // PLATFORM_POSIX
+
+#endif // RT_LOOP_H
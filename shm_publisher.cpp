@@ -0,0 +1,330 @@
+/** InstAI Co. (Public Version)
+    Description: Shared-memory ring publishing OD results and JPEGs to other processes on the host
+    Modified Date: Oct 19, 2026
+*/
+#include "shm_publisher.h"
+
+#ifdef PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+//-- Constant values
+#define SLOT_ALIGNMENT 64   // keep each slot on its own cache lines
+#define SLOTS_OFFSET ((sizeof(struct shm_ring_header_struct) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT)
+
+/* ---- internal function prototypes declaration ---- */
+static uint64_t get_timestamp_us();
+static uint32_t make_generation();
+static struct shm_slot_header_struct *get_slot(const struct shm_ring_header_struct *header, uint64_t seq);
+static uint64_t publish(enum SHM_MESSAGE_TYPE type, const uint8_t *payload, size_t payload_size, const struct od_data_struct *od_result);
+static bool is_restarted(const struct shm_subscriber_struct *subscriber);
+static bool reopen(struct shm_subscriber_struct *subscriber);
+static bool check_restart(struct shm_subscriber_struct *subscriber);
+
+//-- Global variables
+static struct shm_ring_header_struct *publisher_header = NULL;
+static size_t publisher_map_size = 0;
+static char publisher_name[SHM_RING_NAME_SIZE] = { 0 };
+
+static uint64_t get_timestamp_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t make_generation()
+{
+    // differs between the successive publishers of the same name, 0 is reserved for a closed ring
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint32_t generation = (uint32_t)ts.tv_sec * 1000003U ^ (uint32_t)ts.tv_nsec ^ (uint32_t)getpid() << 16;
+    return generation != 0 ? generation : 1;
+}
+
+static struct shm_slot_header_struct *get_slot(const struct shm_ring_header_struct *header, uint64_t seq)
+{
+    uint8_t *slots = (uint8_t *)header + SLOTS_OFFSET;
+    return (struct shm_slot_header_struct *)(slots + (size_t)(seq % header->slot_num) * header->slot_size);
+}
+
+bool shm_publisher_open(const char *name, uint32_t slot_num)
+{
+    shm_publisher_close();
+
+    if(slot_num == 0)
+        slot_num = SHM_RING_DEFAULT_SLOTS;
+
+    uint32_t slot_size = (sizeof(struct shm_slot_header_struct) + SHM_SLOT_PAYLOAD_SIZE + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+    size_t map_size = SLOTS_OFFSET + (size_t)slot_size * slot_num;
+
+    // never reuse a ring left by a previous publisher: truncating it under the subscribers' mappings would raise SIGBUS,
+    // they keep reading the unlinked ring until they notice the new one
+    shm_unlink(name);
+    // consumers only need read access
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0)
+        return false;
+    if(ftruncate(fd, map_size) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return false;
+    }
+
+    void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return false;
+    }
+
+    publisher_header = (struct shm_ring_header_struct *)map;
+    publisher_map_size = map_size;
+    strncpy(publisher_name, name, sizeof(publisher_name) - 1);
+
+    publisher_header->version = SHM_RING_VERSION;
+    publisher_header->slot_num = slot_num;
+    publisher_header->slot_size = slot_size;
+    publisher_header->head_seq = 0;
+    publisher_header->generation = make_generation();
+    // magic is written last so that subscribers never see a half-initialized header
+    __atomic_store_n(&publisher_header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+void shm_publisher_close()
+{
+    if(publisher_header == NULL)
+        return;
+
+    // wake the waiting subscribers up so that they look for the next ring
+    __atomic_store_n(&publisher_header->generation, 0, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&publisher_header->notify_word, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &publisher_header->notify_word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    munmap(publisher_header, publisher_map_size);
+    shm_unlink(publisher_name);
+    publisher_header = NULL;
+    publisher_map_size = 0;
+    memset(publisher_name, 0, sizeof(publisher_name));
+}
+
+static uint64_t publish(enum SHM_MESSAGE_TYPE type, const uint8_t *payload, size_t payload_size, const struct od_data_struct *od_result)
+{
+    if(publisher_header == NULL || payload_size > SHM_SLOT_PAYLOAD_SIZE)
+        return 0;
+
+    uint64_t seq = publisher_header->head_seq + 1;
+    struct shm_slot_header_struct *slot = get_slot(publisher_header, seq);
+    uint32_t lock = slot->seqlock;
+
+    // odd seqlock: the slot is being written, subscribers reading it would retry or drop the message
+    __atomic_store_n(&slot->seqlock, lock + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->type = type;
+    slot->seq = seq;
+    slot->timestamp_us = get_timestamp_us();
+    slot->payload_size = (uint32_t)payload_size;
+    if(od_result != NULL)
+        memcpy(&slot->od_result, od_result, sizeof(struct od_data_struct));
+    else
+        memset(&slot->od_result, 0, sizeof(struct od_data_struct));
+    if(payload_size > 0)
+        memcpy((uint8_t *)slot + sizeof(struct shm_slot_header_struct), payload, payload_size);
+
+    __atomic_store_n(&slot->seqlock, lock + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&publisher_header->head_seq, seq, __ATOMIC_RELEASE);
+
+    // a single wake-up call whatever the number of waiting subscribers
+    __atomic_add_fetch(&publisher_header->notify_word, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &publisher_header->notify_word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    return seq;
+}
+
+uint64_t shm_publisher_publish_od(const struct od_data_struct *od_result)
+{
+    return publish(SHM_MESSAGE_OD, NULL, 0, od_result);
+}
+
+uint64_t shm_publisher_publish_jpeg(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_data_struct *od_result)
+{
+    return publish(SHM_MESSAGE_JPEG, jpeg_data, jpeg_size, od_result);
+}
+
+bool shm_subscriber_open(struct shm_subscriber_struct *subscriber, const char *name)
+{
+    struct stat st;
+
+    memset(subscriber, 0, sizeof(struct shm_subscriber_struct));
+    subscriber->fd = shm_open(name, O_RDONLY, 0);
+    if(subscriber->fd < 0)
+        return false;
+
+    if(fstat(subscriber->fd, &st) != 0 || (size_t)st.st_size < sizeof(struct shm_ring_header_struct))
+    {
+        close(subscriber->fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, subscriber->fd, 0);
+    if(map == MAP_FAILED)
+    {
+        close(subscriber->fd);
+        return false;
+    }
+
+    subscriber->map = (const uint8_t *)map;
+    subscriber->map_size = st.st_size;
+    subscriber->header = (const struct shm_ring_header_struct *)map;
+    if(__atomic_load_n(&subscriber->header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+        subscriber->header->version != SHM_RING_VERSION ||
+        subscriber->header->slot_num == 0 ||
+        subscriber->header->slot_size < sizeof(struct shm_slot_header_struct) + SHM_SLOT_PAYLOAD_SIZE ||
+        subscriber->map_size < SLOTS_OFFSET + (size_t)subscriber->header->slot_num * subscriber->header->slot_size)
+    {
+        shm_subscriber_close(subscriber);
+        return false;
+    }
+
+    strncpy(subscriber->name, name, sizeof(subscriber->name) - 1);
+    subscriber->generation = __atomic_load_n(&subscriber->header->generation, __ATOMIC_ACQUIRE);
+    subscriber->next_seq = __atomic_load_n(&subscriber->header->head_seq, __ATOMIC_ACQUIRE) + 1;
+    subscriber->checked_us = get_timestamp_us();
+    return true;
+}
+
+void shm_subscriber_close(struct shm_subscriber_struct *subscriber)
+{
+    if(subscriber->map != NULL)
+        munmap((void *)subscriber->map, subscriber->map_size);
+    if(subscriber->fd >= 0)
+        close(subscriber->fd);
+    memset(subscriber, 0, sizeof(struct shm_subscriber_struct));
+    subscriber->fd = -1;
+}
+
+static bool is_restarted(const struct shm_subscriber_struct *subscriber)
+{
+    return __atomic_load_n(&subscriber->header->generation, __ATOMIC_ACQUIRE) != subscriber->generation ||
+        __atomic_load_n(&subscriber->header->head_seq, __ATOMIC_ACQUIRE) + 1 < subscriber->next_seq;
+}
+
+static bool reopen(struct shm_subscriber_struct *subscriber)
+{
+    struct shm_subscriber_struct renewed;
+    bool is_backwards = __atomic_load_n(&subscriber->header->head_seq, __ATOMIC_ACQUIRE) + 1 < subscriber->next_seq;
+
+    // keep the current ring until the publisher has created a new one
+    if(!shm_subscriber_open(&renewed, subscriber->name))
+        return false;
+    if(renewed.generation == 0 || (renewed.generation == subscriber->generation && !is_backwards))
+    {
+        shm_subscriber_close(&renewed);
+        return false;
+    }
+
+    // read the new ring from its oldest message
+    uint64_t head = __atomic_load_n(&renewed.header->head_seq, __ATOMIC_ACQUIRE);
+    renewed.next_seq = head >= renewed.header->slot_num ? head - renewed.header->slot_num + 1 : 1;
+    renewed.lost = subscriber->lost;
+    renewed.restarts = subscriber->restarts + 1;
+    shm_subscriber_close(subscriber);
+    *subscriber = renewed;
+    return true;
+}
+
+static bool check_restart(struct shm_subscriber_struct *subscriber)
+{
+    // a closed ring or sequence numbers going backwards are seen at once, the ring of a crashed publisher
+    // is only replaced under its name which is looked up every SHM_SUBSCRIBER_CHECK_MS
+    uint64_t now = get_timestamp_us();
+    if(!is_restarted(subscriber) && now - subscriber->checked_us < SHM_SUBSCRIBER_CHECK_MS * 1000ULL)
+        return false;
+
+    subscriber->checked_us = now;
+    return reopen(subscriber);
+}
+
+bool shm_subscriber_wait(struct shm_subscriber_struct *subscriber, int32_t timeout_ms)
+{
+    struct timespec timeout;
+    uint32_t waited_ms = 0;
+
+    while(1)
+    {
+        // read notify_word before head_seq so that a message published in between wakes the futex up
+        uint32_t notify = __atomic_load_n(&subscriber->header->notify_word, __ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&subscriber->header->head_seq, __ATOMIC_ACQUIRE) >= subscriber->next_seq)
+            return true;
+        if(check_restart(subscriber))
+            continue;
+        if(timeout_ms >= 0 && waited_ms >= (uint32_t)timeout_ms)
+            return false;
+
+        // wait in slices so that the ring of a restarted publisher is found while waiting forever
+        uint32_t slice_ms = SHM_SUBSCRIBER_CHECK_MS;
+        if(timeout_ms >= 0 && (uint32_t)timeout_ms - waited_ms < slice_ms)
+            slice_ms = (uint32_t)timeout_ms - waited_ms;
+        timeout.tv_sec = slice_ms / 1000;
+        timeout.tv_nsec = (slice_ms % 1000) * 1000000L;
+
+        // FUTEX_WAIT only reads the futex word, it works on the read-only mapping
+        if(syscall(SYS_futex, &subscriber->header->notify_word, FUTEX_WAIT, notify, &timeout, NULL, 0) != 0 && errno == ETIMEDOUT)
+            waited_ms += slice_ms;
+    }
+}
+
+bool shm_subscriber_peek(struct shm_subscriber_struct *subscriber, struct shm_message_struct *message)
+{
+    if(__atomic_load_n(&subscriber->header->head_seq, __ATOMIC_ACQUIRE) < subscriber->next_seq)
+        check_restart(subscriber);
+
+    const struct shm_ring_header_struct *header = subscriber->header;
+    uint64_t head = __atomic_load_n(&header->head_seq, __ATOMIC_ACQUIRE);
+
+    if(head < subscriber->next_seq)
+        return false;
+
+    // skip the messages which have already been overwritten
+    if(head - subscriber->next_seq >= header->slot_num)
+    {
+        uint64_t oldest = head - header->slot_num + 1;
+        subscriber->lost += oldest - subscriber->next_seq;
+        subscriber->next_seq = oldest;
+    }
+
+    const struct shm_slot_header_struct *slot = get_slot(header, subscriber->next_seq);
+    uint32_t lock = __atomic_load_n(&slot->seqlock, __ATOMIC_ACQUIRE);
+
+    message->slot = slot;
+    message->seqlock = lock;
+    message->type = (enum SHM_MESSAGE_TYPE)slot->type;
+    message->seq = slot->seq;
+    message->timestamp_us = slot->timestamp_us;
+    message->od_result = &slot->od_result;
+    message->payload = (const uint8_t *)slot + sizeof(struct shm_slot_header_struct);
+    message->payload_size = slot->payload_size;
+    if(message->payload_size > SHM_SLOT_PAYLOAD_SIZE)
+        message->payload_size = 0;
+    return true;
+}
+
+bool shm_subscriber_release(struct shm_subscriber_struct *subscriber, const struct shm_message_struct *message)
+{
+    // order the reads of the message before the second seqlock read
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint32_t lock = __atomic_load_n(&message->slot->seqlock, __ATOMIC_RELAXED);
+    bool valid = (message->seqlock & 1) == 0 && lock == message->seqlock && message->seq == subscriber->next_seq;
+
+    if(!valid)
+        subscriber->lost++;
+    subscriber->next_seq++;
+    return valid;
+}
+
+#endif // PLATFORM_POSIX
@@ -0,0 +1,205 @@
+/** InstAI Co. (Public Version)
+    Description: Shared-memory ring publishing OD results and JPEGs to other processes on the host
+    Modified Date: Oct 19, 2026
+    Remark: requires a Linux host (POSIX shared memory and futex, link with -lrt on older glibc),
+        the publisher never waits for the subscribers: each message is written into the next slot of the ring
+        under a per-slot sequence lock, and subscribers map the ring read-only and read the messages in place,
+        a restarted publisher creates a new ring under the same name and the subscribers move to it
+*/
+
+#ifndef SHM_PUBLISHER_H
+#define SHM_PUBLISHER_H
+
+#include "ai_module.h"
+
+#ifdef PLATFORM_POSIX
+
+//-- Constant values
+#define SHM_RING_MAGIC          0x41494D52      // "AIMR"
+#define SHM_RING_VERSION        2
+#define SHM_RING_DEFAULT_SLOTS  64
+#define SHM_SLOT_PAYLOAD_SIZE   AI_MODULE_BUFFER_SIZE   // largest JPEG retrieved from AI module
+#define SHM_RING_NAME_SIZE      64
+#define SHM_SUBSCRIBER_CHECK_MS 1000    // interval at which a waiting subscriber checks whether the publisher was restarted
+
+//-- Enumerations
+/**
+    @brief: type of a published message
+*/
+enum SHM_MESSAGE_TYPE
+{
+    SHM_MESSAGE_OD = 1,         // OD result only
+    SHM_MESSAGE_JPEG = 2        // JPEG in payload, with OD result (object_num = 0 if the JPEG has no OD result)
+};
+
+//-- Structures
+/**
+    @brief: header at the beginning of the shared memory object
+    @remark: head_seq is the sequence number of the latest published message (0 if none),
+        notify_word changes on every message so that subscribers can wait on it with FUTEX_WAIT,
+        generation identifies the ring created by shm_publisher_open() and becomes 0 once the publisher closed it
+*/
+struct shm_ring_header_struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserve;
+    uint32_t slot_num;
+    uint32_t slot_size;         // size of a slot including shm_slot_header_struct
+    uint64_t head_seq;
+    uint32_t notify_word;
+    uint32_t generation;
+};
+
+/**
+    @brief: header of a slot, followed by the payload
+    @remark: seqlock is odd while the publisher writes the slot, a subscriber's read is consistent if
+        seqlock has the same even value before and after reading
+*/
+struct shm_slot_header_struct {
+    uint32_t seqlock;
+    uint32_t type;              // one of SHM_MESSAGE_TYPE
+    uint64_t seq;               // sequence number of the message, starts from 1
+    uint64_t timestamp_us;      // CLOCK_MONOTONIC time of the publication
+    uint32_t payload_size;
+    uint32_t reserve;
+    struct od_data_struct od_result;
+};
+
+/**
+    @brief: message returned by shm_subscriber_peek(), points into the shared memory (no copy)
+    @remark: the content is only valid if shm_subscriber_release() returns true
+*/
+struct shm_message_struct {
+    enum SHM_MESSAGE_TYPE type;
+    uint64_t seq;
+    uint64_t timestamp_us;
+    const struct od_data_struct *od_result;
+    const uint8_t *payload;
+    uint32_t payload_size;
+    uint32_t seqlock;           // seqlock value observed by shm_subscriber_peek()
+    const struct shm_slot_header_struct *slot;
+};
+
+/**
+    @brief: state of a subscriber process
+*/
+struct shm_subscriber_struct {
+    int fd;
+    const uint8_t *map;
+    size_t map_size;
+    const struct shm_ring_header_struct *header;
+    char name[SHM_RING_NAME_SIZE];
+    uint32_t generation;        // generation of the mapped ring
+    uint64_t next_seq;          // sequence number of the next message to read
+    uint64_t lost;              // number of messages overwritten before they were read
+    uint32_t restarts;          // number of times the subscriber moved to the ring of a restarted publisher
+    uint64_t checked_us;        // last time the ring name was looked up
+};
+
+/* ---- publisher (process owning the AI module) ---- */
+/**
+    @brief: create the shared memory ring
+    @parameter:
+        name:       POSIX shared memory object name, e.g. "/ai_module_events"
+        slot_num:   number of messages kept in the ring, 0 uses SHM_RING_DEFAULT_SLOTS
+    @return:
+        return true if the ring is created successfully
+        otherwise, return false
+    @remark: a ring left under the same name (e.g. by a crashed publisher) is unlinked, not reused, so that the
+        subscribers still mapping it are not affected until they move to the new ring
+*/
+bool shm_publisher_open(const char *name, uint32_t slot_num);
+
+/**
+    @brief: remove the shared memory ring
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+    @remark: subscribers which still map the ring keep their mapping but receive no more messages,
+        they move to the ring of the next shm_publisher_open() with the same name
+*/
+void shm_publisher_close();
+
+/**
+    @brief: publish an OD result
+    @parameter:
+        od_result: OD result retrieved by ai_module_process_event()
+    @return:
+        sequence number of the message, 0 if the ring is not opened
+*/
+uint64_t shm_publisher_publish_od(const struct od_data_struct *od_result);
+
+/**
+    @brief: publish a JPEG and its OD result
+    @parameter:
+        jpeg_data:  JPEG data provided by the save JPEG function
+        jpeg_size:  size of JPEG data (up to SHM_SLOT_PAYLOAD_SIZE)
+        od_result:  OD result of the JPEG, or NULL
+    @return:
+        sequence number of the message, 0 if the ring is not opened or the JPEG is too large
+*/
+uint64_t shm_publisher_publish_jpeg(const uint8_t *jpeg_data, size_t jpeg_size, const struct od_data_struct *od_result);
+
+/* ---- subscriber (consumer processes) ---- */
+/**
+    @brief: map the shared memory ring read-only
+    @parameter:
+        subscriber: the subscriber state to initialize
+        name:       POSIX shared memory object name given to shm_publisher_open()
+    @return:
+        return true if the ring is mapped successfully
+        otherwise, return false
+    @remark: the subscriber starts with the next published message
+*/
+bool shm_subscriber_open(struct shm_subscriber_struct *subscriber, const char *name);
+
+/**
+    @brief: unmap the shared memory ring
+    @parameter:
+        subscriber: the subscriber state
+    @return:
+        (NONE)
+*/
+void shm_subscriber_close(struct shm_subscriber_struct *subscriber);
+
+/**
+    @brief: wait until a new message is published
+    @parameter:
+        subscriber: the subscriber state
+        timeout_ms: maximum waiting time, 0 returns immediately, -1 waits forever
+    @return:
+        return true if a message is available
+        otherwise, return false (timeout)
+    @remark: when no message is available, the subscriber checks (every SHM_SUBSCRIBER_CHECK_MS at most) whether
+        the publisher was restarted and moves to the new ring from its oldest message
+*/
+bool shm_subscriber_wait(struct shm_subscriber_struct *subscriber, int32_t timeout_ms);
+
+/**
+    @brief: get the next message in place
+    @parameter:
+        subscriber: the subscriber state
+        message:    give the variable with type "shm_message_struct" to point to the message
+    @return:
+        return true if a message is available
+        otherwise, return false
+    @remark: if the subscriber fell behind by more than the ring size, the overwritten messages are skipped and counted in "lost",
+        when no message is available, the restart of the publisher is checked as in shm_subscriber_wait()
+*/
+bool shm_subscriber_peek(struct shm_subscriber_struct *subscriber, struct shm_message_struct *message);
+
+/**
+    @brief: finish reading the message returned by shm_subscriber_peek() and move to the next one
+    @parameter:
+        subscriber: the subscriber state
+        message:    the message returned by shm_subscriber_peek()
+    @return:
+        return true if the message was not overwritten while it was read (the read data is valid)
+        otherwise, return false (the message is counted in "lost")
+*/
+bool shm_subscriber_release(struct shm_subscriber_struct *subscriber, const struct shm_message_struct *message);
+
+#endif // PLATFORM_POSIX
+
+#endif // SHM_PUBLISHER_H
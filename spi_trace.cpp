@@ -0,0 +1,300 @@
+/** InstAI Co. (Public Version)
+    Description: SPI transaction capture and deterministic replay for the AI module driver
+    Modified Date: Oct 19, 2026
+*/
+#include "spi_trace.h"
+
+#ifdef PLATFORM_POSIX
+
+//-- Constant values
+#define SPI_TRACE_BUFFER_SIZE       4096
+#define SPI_TRACE_MAX_RECORD_SIZE   7           // 2 bytes transaction + 5 bytes LEB128 time delta
+#define SPI_TRACE_FLUSH_PERIOD_US   1000000     // flush the buffered records at least once per second
+#define SPI_TRACE_MISMATCH_PRINTS   8           // number of diverged transactions printed during replay
+
+/* ---- capture ---- */
+//-- Global variables
+static FILE *capture_fp = NULL;
+static uint8_t capture_buffer[SPI_TRACE_BUFFER_SIZE];
+static uint32_t capture_buffer_len = 0;
+static uint32_t capture_last_us = 0;
+static uint32_t capture_last_flush_us = 0;
+
+bool spi_trace_capture_start(const char *file_path)
+{
+    uint8_t header[SPI_TRACE_HEADER_SIZE] = { 0 };
+
+    spi_trace_capture_stop();
+
+    capture_fp = fopen(file_path, "wb");
+    if(capture_fp == NULL)
+        return false;
+
+    memcpy(header, SPI_TRACE_MAGIC, 4);
+    header[4] = SPI_TRACE_VERSION;
+    if(fwrite(header, 1, SPI_TRACE_HEADER_SIZE, capture_fp) != SPI_TRACE_HEADER_SIZE)
+    {
+        fclose(capture_fp);
+        capture_fp = NULL;
+        return false;
+    }
+
+    capture_buffer_len = 0;
+    capture_last_us = interface_micros();
+    capture_last_flush_us = capture_last_us;
+    return true;
+}
+
+void spi_trace_capture_flush()
+{
+    if(capture_fp == NULL)
+        return;
+
+    if(capture_buffer_len > 0)
+        fwrite(capture_buffer, 1, capture_buffer_len, capture_fp);
+    fflush(capture_fp);
+    capture_buffer_len = 0;
+    capture_last_flush_us = interface_micros();
+}
+
+void spi_trace_capture_stop()
+{
+    if(capture_fp == NULL)
+        return;
+
+    spi_trace_capture_flush();
+    fclose(capture_fp);
+    capture_fp = NULL;
+}
+
+void spi_trace_record(enum SPI_TRACE_OP op, uint8_t address, uint8_t data)
+{
+    if(capture_fp == NULL)
+        return;
+
+    uint32_t now = interface_micros();
+    uint32_t delta = now - capture_last_us;
+    capture_last_us = now;
+
+    capture_buffer[capture_buffer_len++] = (uint8_t)((op << 7) | (address & 0x7F));
+    capture_buffer[capture_buffer_len++] = data;
+    do
+    {   // unsigned LEB128: 7 bits per byte, MSB set when more bytes follow
+        uint8_t byte = delta & 0x7F;
+        delta >>= 7;
+        if(delta != 0)
+            byte |= 0x80;
+        capture_buffer[capture_buffer_len++] = byte;
+    } while (delta != 0);
+
+    if((capture_buffer_len > SPI_TRACE_BUFFER_SIZE - SPI_TRACE_MAX_RECORD_SIZE) ||
+        (now - capture_last_flush_us >= SPI_TRACE_FLUSH_PERIOD_US))
+        spi_trace_capture_flush();
+}
+
+#endif // PLATFORM_POSIX
+
+#ifdef PLATFORM_HOST_SIM
+
+/* ---- replay ---- */
+//-- Structure
+struct replay_record_struct
+{
+    uint8_t op;
+    uint8_t address;
+    uint8_t data;
+    uint64_t time_us;   // recorded time offset from the first record
+};
+
+/* ---- internal function prototypes declaration ---- */
+static bool replay_next_record(struct replay_record_struct *record);
+static void replay_wait_until(uint64_t time_us);
+static uint64_t replay_elapsed_us();
+static void replay_check(uint8_t op, uint8_t address, uint8_t data, struct replay_record_struct *record);
+static uint8_t replay_read(uint8_t address);
+static void replay_write(uint8_t address, uint8_t data);
+
+//-- Global variables
+static uint8_t *replay_trace = NULL;
+static size_t replay_trace_size = 0;
+static size_t replay_offset = 0;
+static enum SPI_TRACE_REPLAY_TIMING replay_timing = SPI_TRACE_REPLAY_AS_FAST_AS_POSSIBLE;
+static uint64_t replay_recorded_us = 0;
+static uint64_t replay_host_us = 0;
+static uint32_t replay_last_micros = 0;
+static struct spi_trace_replay_stats_struct replay_stats;
+static const struct interface_sim_device replay_device = { replay_read, replay_write };
+
+bool spi_trace_replay_open(const char *file_path, enum SPI_TRACE_REPLAY_TIMING timing)
+{
+    FILE *fp;
+    long file_size = 0;
+
+    spi_trace_replay_close();
+
+    fp = fopen(file_path, "rb");
+    if(fp == NULL)
+        return false;
+
+    if(fseek(fp, 0, SEEK_END) != 0 || (file_size = ftell(fp)) < SPI_TRACE_HEADER_SIZE || fseek(fp, 0, SEEK_SET) != 0)
+    {
+        fclose(fp);
+        return false;
+    }
+
+    replay_trace = (uint8_t *)malloc(file_size);
+    if(replay_trace == NULL || fread(replay_trace, 1, file_size, fp) != (size_t)file_size ||
+        memcmp(replay_trace, SPI_TRACE_MAGIC, 4) != 0 || replay_trace[4] != SPI_TRACE_VERSION)
+    {
+        fclose(fp);
+        spi_trace_replay_close();
+        return false;
+    }
+    fclose(fp);
+
+    replay_trace_size = file_size;
+    replay_offset = SPI_TRACE_HEADER_SIZE;
+    replay_timing = timing;
+    replay_recorded_us = 0;
+    replay_host_us = 0;
+    replay_last_micros = interface_micros();
+    memset(&replay_stats, 0, sizeof(struct spi_trace_replay_stats_struct));
+
+    // count the transactions once so that progress can be reported against the total
+    struct replay_record_struct record;
+    while(replay_next_record(&record))
+        replay_stats.total_transactions++;
+    replay_offset = SPI_TRACE_HEADER_SIZE;
+    replay_recorded_us = 0;
+
+    return true;
+}
+
+const struct interface_sim_device *spi_trace_replay_device()
+{
+    return &replay_device;
+}
+
+bool spi_trace_replay_finished()
+{
+    return replay_offset >= replay_trace_size;
+}
+
+void spi_trace_replay_get_stats(struct spi_trace_replay_stats_struct *stats)
+{
+    replay_stats.recorded_us = replay_recorded_us;
+    replay_stats.elapsed_us = replay_elapsed_us();
+    memcpy(stats, &replay_stats, sizeof(struct spi_trace_replay_stats_struct));
+}
+
+void spi_trace_replay_close()
+{
+    if(replay_trace != NULL)
+        free(replay_trace);
+    replay_trace = NULL;
+    replay_trace_size = 0;
+    replay_offset = 0;
+}
+
+static bool replay_next_record(struct replay_record_struct *record)
+{
+    uint64_t delta = 0;
+    uint8_t shift = 0, byte = 0;
+
+    if(replay_offset + 3 > replay_trace_size)
+    {
+        replay_offset = replay_trace_size;
+        return false;
+    }
+
+    record->op = replay_trace[replay_offset] >> 7;
+    record->address = replay_trace[replay_offset] & 0x7F;
+    record->data = replay_trace[replay_offset + 1];
+    replay_offset += 2;
+
+    do
+    {
+        byte = replay_trace[replay_offset++];
+        delta |= (uint64_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while ((byte & 0x80) && replay_offset < replay_trace_size && shift < 35);
+
+    replay_recorded_us += delta;
+    record->time_us = replay_recorded_us;
+    return true;
+}
+
+static uint64_t replay_elapsed_us()
+{   // accumulate the 32-bit host counter into 64 bits so that long traces do not wrap around
+    uint32_t now = interface_micros();
+    replay_host_us += (uint32_t)(now - replay_last_micros);
+    replay_last_micros = now;
+    return replay_host_us;
+}
+
+static void replay_wait_until(uint64_t time_us)
+{
+    uint64_t elapsed = replay_elapsed_us();
+    while(elapsed < time_us)
+    {
+        interface_delay_us((uint32_t)(time_us - elapsed));
+        elapsed = replay_elapsed_us();
+    }
+}
+
+static void replay_check(uint8_t op, uint8_t address, uint8_t data, struct replay_record_struct *record)
+{
+    // the value of a read comes from the trace, the value of a write is the driver's own
+    bool is_value_mismatch = record->op == op && record->address == address && op == SPI_TRACE_OP_WRITE && record->data != data;
+    if(record->op == op && record->address == address && !is_value_mismatch)
+        return;
+
+    if(replay_stats.mismatches == 0)
+        replay_stats.first_mismatch_index = replay_stats.transactions;
+    if(replay_stats.mismatches < SPI_TRACE_MISMATCH_PRINTS)
+    {
+        if(is_value_mismatch)
+            printf("SPI trace diverged at #%u: expected write 0x%02X = 0x%02X, driver wrote 0x%02X\n", replay_stats.transactions,
+                address, record->data, data);
+        else
+            printf("SPI trace diverged at #%u: expected %s 0x%02X, driver issued %s 0x%02X\n", replay_stats.transactions,
+                record->op == SPI_TRACE_OP_READ ? "read" : "write", record->address,
+                op == SPI_TRACE_OP_READ ? "read" : "write", address);
+    }
+    if(is_value_mismatch)
+        replay_stats.value_mismatches++;
+    replay_stats.mismatches++;
+}
+
+static uint8_t replay_read(uint8_t address)
+{
+    struct replay_record_struct record;
+
+    if(!replay_next_record(&record))
+        return 0;
+
+    if(replay_timing == SPI_TRACE_REPLAY_ORIGINAL_TIMING)
+        replay_wait_until(record.time_us);
+
+    replay_check(SPI_TRACE_OP_READ, address, 0, &record);
+    replay_stats.transactions++;
+
+    // a diverged write has no response, keep the bus idle value
+    return record.op == SPI_TRACE_OP_READ ? record.data : 0;
+}
+
+static void replay_write(uint8_t address, uint8_t data)
+{
+    struct replay_record_struct record;
+
+    if(!replay_next_record(&record))
+        return;
+
+    if(replay_timing == SPI_TRACE_REPLAY_ORIGINAL_TIMING)
+        replay_wait_until(record.time_us);
+
+    replay_check(SPI_TRACE_OP_WRITE, address, data, &record);
+    replay_stats.transactions++;
+}
+
+#endif // PLATFORM_HOST_SIM
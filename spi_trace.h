@@ -0,0 +1,161 @@
+/** InstAI Co. (Public Version)
+    Description: SPI transaction capture and deterministic replay for the AI module driver
+    Modified Date: Oct 19, 2026
+    Remark: capture requires a POSIX platform (AI_MODULE_SPI_TRACE defined in interface.h),
+        replay requires PLATFORM_HOST_SIM so that ai_module.cpp is served from the recorded trace
+*/
+
+#ifndef SPI_TRACE_H
+#define SPI_TRACE_H
+
+#include "interface.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/**
+    Trace file layout (little endian):
+        header:  "AIST" magic (4 bytes), format version (1 byte), reserved (3 bytes)
+        records: byte 0 = (op << 7) | register address (7 bits)
+                 byte 1 = data written to / read from the register
+                 byte 2.. = microseconds elapsed since the previous record, unsigned LEB128 (1 to 5 bytes)
+    A typical register access costs 3 to 4 bytes in the trace.
+*/
+#define SPI_TRACE_MAGIC         "AIST"
+#define SPI_TRACE_VERSION       0x01
+#define SPI_TRACE_HEADER_SIZE   8
+
+//-- Enumerations
+/**
+    @brief: direction of a recorded SPI transaction
+*/
+enum SPI_TRACE_OP
+{
+    SPI_TRACE_OP_WRITE = 0x00,
+    SPI_TRACE_OP_READ = 0x01
+};
+
+/**
+    @brief: pacing of the replayed transactions
+    @remark: SPI_TRACE_REPLAY_AS_FAST_AS_POSSIBLE serves each transaction immediately (benchmark),
+        SPI_TRACE_REPLAY_ORIGINAL_TIMING holds each transaction until its recorded time offset is reached
+*/
+enum SPI_TRACE_REPLAY_TIMING
+{
+    SPI_TRACE_REPLAY_AS_FAST_AS_POSSIBLE = 0,
+    SPI_TRACE_REPLAY_ORIGINAL_TIMING
+};
+
+//-- Structures
+/**
+    @brief: statistics of the replay session
+    @remark: a mismatch means the driver issued a different transaction (direction or address) or wrote a different value
+        than the one recorded at the same position, i.e. the driver behaviour diverged from the capture
+*/
+struct spi_trace_replay_stats_struct {
+    uint32_t transactions;          // number of replayed transactions
+    uint32_t total_transactions;    // number of transactions in the trace
+    uint32_t mismatches;
+    uint32_t value_mismatches;      // writes to the recorded address with another value (included in mismatches)
+    uint32_t first_mismatch_index;  // index of the first diverged transaction, valid if mismatches > 0
+    uint64_t recorded_us;           // recorded duration of the replayed transactions
+    uint64_t elapsed_us;            // host time spent on the replay
+};
+
+#ifdef PLATFORM_POSIX
+/**
+    @brief: start recording every SPI transaction into the given trace file
+    @parameter:
+        file_path: path of the trace file, an existing file would be overwritten
+    @return:
+        return true if the trace file is created successfully
+        otherwise, return false
+    @remark: call it after interface_spi_init() and before ai_module_init() to capture the whole session,
+        records are buffered and written to the file at least once per second
+*/
+bool spi_trace_capture_start(const char *file_path);
+
+/**
+    @brief: write the buffered records into the trace file
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+*/
+void spi_trace_capture_flush();
+
+/**
+    @brief: flush the buffered records and close the trace file
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+*/
+void spi_trace_capture_stop();
+
+/**
+    @brief: append a transaction to the trace, called by interface_spi_read()/interface_spi_write()
+    @parameter:
+        op:         direction of the transaction
+        address:    register address (without read flag)
+        data:       data written to the register, or data read from the register
+    @return:
+        (NONE)
+    @remark: does nothing if capture has not been started
+*/
+void spi_trace_record(enum SPI_TRACE_OP op, uint8_t address, uint8_t data);
+#endif // PLATFORM_POSIX
+
+#ifdef PLATFORM_HOST_SIM
+/**
+    @brief: load the trace file to replay
+    @parameter:
+        file_path:  path of the trace file recorded by spi_trace_capture_start()
+        timing:     one of the pacing options defined in enumeration SPI_TRACE_REPLAY_TIMING
+    @return:
+        return true if the trace file is loaded successfully
+        otherwise, return false
+    @remark: pass spi_trace_replay_device() to interface_spi_init() after the trace is loaded
+*/
+bool spi_trace_replay_open(const char *file_path, enum SPI_TRACE_REPLAY_TIMING timing);
+
+/**
+    @brief: get the simulated AI module serving transactions from the loaded trace
+    @parameter:
+        (NONE)
+    @return:
+        simulated device to be passed to interface_spi_init()
+    @remark: once the trace is exhausted, every read returns 0 and every write is ignored
+*/
+const struct interface_sim_device *spi_trace_replay_device();
+
+/**
+    @brief: check whether all recorded transactions have been replayed
+    @parameter:
+        (NONE)
+    @return:
+        return true if the trace is exhausted (or not loaded)
+        otherwise, return false
+*/
+bool spi_trace_replay_finished();
+
+/**
+    @brief: get the statistics of the replay session
+    @parameter:
+        stats: give the variable with type "spi_trace_replay_stats_struct" to store the statistics
+    @return:
+        (NONE)
+*/
+void spi_trace_replay_get_stats(struct spi_trace_replay_stats_struct *stats);
+
+/**
+    @brief: release the loaded trace
+    @parameter:
+        (NONE)
+    @return:
+        (NONE)
+*/
+void spi_trace_replay_close();
+#endif // PLATFORM_HOST_SIM
+
+#endif // SPI_TRACE_H
@@ -0,0 +1,177 @@
+/** InstAI Co. (Public Version)
+    Description: Closed-loop controller of the OD event triggering thresholds capping the event rate of each object type
+    Modified Date: Oct 19, 2026
+*/
+#include "threshold_controller.h"
+
+/* ---- internal function prototypes declaration ---- */
+static uint8_t get_bin(uint8_t confidence);
+static uint16_t get_bin_end(uint8_t bin);
+static uint8_t get_budget_threshold(const struct threshold_controller_struct *controller, uint8_t type_index);
+static bool adjust_type(struct threshold_controller_struct *controller, uint8_t type_index);
+
+static uint8_t get_bin(uint8_t confidence)
+{
+    // the thresholds are set within the fine bins, the levels below and above only need to be counted
+    if(confidence < THRESHOLD_CONTROLLER_FINE_FIRST)
+        return 0;
+    uint16_t bin = 1 + (confidence - THRESHOLD_CONTROLLER_FINE_FIRST) / THRESHOLD_CONTROLLER_FINE_WIDTH;
+    return bin < THRESHOLD_CONTROLLER_CONF_BINS - 1 ? (uint8_t)bin : THRESHOLD_CONTROLLER_CONF_BINS - 1;
+}
+
+static uint16_t get_bin_end(uint8_t bin)
+{
+    // lowest confidence level above the bin
+    if(bin >= THRESHOLD_CONTROLLER_CONF_BINS - 1)
+        return 256;
+    return THRESHOLD_CONTROLLER_FINE_FIRST + bin * THRESHOLD_CONTROLLER_FINE_WIDTH;
+}
+
+void threshold_controller_default_config(struct threshold_controller_config_struct *config)
+{
+    memset(config, 0, sizeof(struct threshold_controller_config_struct));
+    config->window_ms = 60000;
+    for(uint8_t i = 0; i < MAX_OD_SUPPORT_TYPES; i++)
+    {
+        config->event_budget[i] = 30;
+        config->min_threshold[i] = 30;
+        config->max_threshold[i] = 90;
+    }
+    config->max_step = 10;
+    config->lower_step = 2;
+}
+
+void threshold_controller_init(struct threshold_controller_struct *controller, const struct threshold_controller_config_struct *config,
+    const uint8_t *initial_thresholds, uint32_t now_us)
+{
+    memset(controller, 0, sizeof(struct threshold_controller_struct));
+
+    if(config != NULL)
+        memcpy(&controller->config, config, sizeof(struct threshold_controller_config_struct));
+    else
+        threshold_controller_default_config(&controller->config);
+
+    memcpy(controller->threshold, initial_thresholds, MAX_OD_SUPPORT_TYPES);
+    memcpy(controller->initial_threshold, initial_thresholds, MAX_OD_SUPPORT_TYPES);
+    controller->last_poll_us = now_us;
+}
+
+void threshold_controller_register_log_func(struct threshold_controller_struct *controller, FunPtr_ThresholdAdjusted log_func)
+{
+    controller->log_func = log_func;
+}
+
+void threshold_controller_feed(struct threshold_controller_struct *controller, const struct od_data_struct *od_result)
+{
+    uint8_t max_confidence[MAX_OD_SUPPORT_TYPES] = { 0 };
+    bool seen[MAX_OD_SUPPORT_TYPES] = { false };
+
+    // an event counts once per object type, with the highest confidence of the objects of this type
+    for(uint8_t i = 0; i < od_result->object_num && i < MAX_OD_SUPPORT_OBJECTS; i++)
+    {
+        const struct od_object_unit_struct *object = &od_result->object[i];
+        if(object->object_type < OD_OBJECT_TYPE_OFFSET || object->object_type >= OD_OBJECT_TYPE_OFFSET + MAX_OD_SUPPORT_TYPES)
+            continue;
+
+        uint8_t type_index = object->object_type - OD_OBJECT_TYPE_OFFSET;
+        seen[type_index] = true;
+        if(object->confidence_level > max_confidence[type_index])
+            max_confidence[type_index] = object->confidence_level;
+    }
+
+    for(uint8_t t = 0; t < MAX_OD_SUPPORT_TYPES; t++)
+    {
+        if(!seen[t])
+            continue;
+        if(controller->events[t] < 0xFFFF)
+            controller->events[t]++;
+        uint16_t *bin = &controller->confidence_histogram[t][get_bin(max_confidence[t])];
+        if(*bin < 0xFFFF)
+            (*bin)++;
+    }
+}
+
+static uint8_t get_budget_threshold(const struct threshold_controller_struct *controller, uint8_t type_index)
+{
+    // lowest confidence level keeping the observed events of this window within the budget,
+    // i.e. above the bin which overflowed the budget (the events at the threshold are reported)
+    uint32_t above = 0;
+    for(int16_t b = THRESHOLD_CONTROLLER_CONF_BINS - 1; b >= 0; b--)
+    {
+        above += controller->confidence_histogram[type_index][b];
+        if(above > controller->config.event_budget[type_index])
+        {
+            uint16_t end = get_bin_end((uint8_t)b);
+            return end < 255 ? (uint8_t)end : 255;
+        }
+    }
+    return controller->threshold[type_index];
+}
+
+static bool adjust_type(struct threshold_controller_struct *controller, uint8_t type_index)
+{
+    const struct threshold_controller_config_struct *config = &controller->config;
+    uint16_t budget = config->event_budget[type_index];
+    uint16_t events = controller->events[type_index];
+    int16_t current = controller->threshold[type_index];
+    int16_t target = current;
+
+    if(budget == 0)
+        return false;
+
+    if(events > budget)
+    {   // event storm: raise the threshold toward the confidence level which would have held the budget
+        target = get_budget_threshold(controller, type_index);
+        if(target <= current)
+            target = current + 1;
+        if(target > current + config->max_step)
+            target = current + config->max_step;
+    }
+    else if(events < budget / 2)
+    {   // quiet: events below the threshold are not observable, lower it gently back to the application setting
+        target = current - config->lower_step;
+        if(target < controller->initial_threshold[type_index])
+            target = controller->initial_threshold[type_index];
+        if(target > current)
+            target = current;
+    }
+
+    if(target < config->min_threshold[type_index])
+        target = config->min_threshold[type_index];
+    if(target > config->max_threshold[type_index])
+        target = config->max_threshold[type_index];
+    if(target == current)
+        return false;
+
+    ai_module_set_od_threshold_type(type_index, (uint8_t)target);
+    controller->threshold[type_index] = (uint8_t)target;
+    controller->adjustments++;
+    if(controller->log_func != NULL)
+        controller->log_func(type_index, (uint8_t)current, (uint8_t)target, events, budget);
+    return true;
+}
+
+uint8_t threshold_controller_poll(struct threshold_controller_struct *controller, uint32_t now_us)
+{
+    uint8_t adjusted = 0;
+
+    controller->window_elapsed_us += now_us - controller->last_poll_us;
+    controller->last_poll_us = now_us;
+    if(controller->window_elapsed_us / 1000 < controller->config.window_ms)
+        return 0;
+
+    for(uint8_t t = 0; t < MAX_OD_SUPPORT_TYPES; t++)
+        if(adjust_type(controller, t))
+            adjusted++;
+
+    // start the next control window
+    controller->window_elapsed_us = 0;
+    memset(controller->events, 0, sizeof(controller->events));
+    memset(controller->confidence_histogram, 0, sizeof(controller->confidence_histogram));
+    return adjusted;
+}
+
+bool threshold_controller_is_due(const struct threshold_controller_struct *controller, uint32_t now_us)
+{
+    return (controller->window_elapsed_us + (now_us - controller->last_poll_us)) / 1000 >= controller->config.window_ms;
+}
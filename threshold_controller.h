@@ -0,0 +1,127 @@
+/** InstAI Co. (Public Version)
+    Description: Closed-loop controller of the OD event triggering thresholds capping the event rate of each object type
+    Modified Date: Oct 19, 2026
+    Remark: the controller observes the OD results, and at the end of each control window raises the threshold of
+        the object types exceeding their event budget (to the confidence level that would have kept them within the budget),
+        or lowers it step by step back to its initial value when the type stays well below its budget, always within the operator bounds
+*/
+
+#ifndef THRESHOLD_CONTROLLER_H
+#define THRESHOLD_CONTROLLER_H
+
+#include "ai_module.h"
+
+//-- Constant values
+#define THRESHOLD_CONTROLLER_CONF_BINS  32      // confidence histogram bins
+#define THRESHOLD_CONTROLLER_FINE_FIRST 30      // lowest confidence level of the fine bins
+#define THRESHOLD_CONTROLLER_FINE_WIDTH 2       // levels of each fine bin, the first and last bins hold the levels below and above the fine bins
+
+//-- Function Pointer
+/**
+    @brief: function pointer which points to custom function to log each threshold adjustment
+    @parameter:
+        type_index:     index of the object type in the threshold table (object_type - OD_OBJECT_TYPE_OFFSET)
+        old_threshold:  threshold value before adjustment
+        new_threshold:  threshold value written to AI module
+        events:         number of events of this type in the last control window
+        budget:         event budget of this type per control window
+*/
+typedef void (*FunPtr_ThresholdAdjusted)(uint8_t type_index, uint8_t old_threshold, uint8_t new_threshold, uint16_t events, uint16_t budget);
+
+//-- Structures
+/**
+    @brief: settings of the threshold controller
+    @remark: call threshold_controller_default_config() to fill the recommended values before customizing the settings
+*/
+struct threshold_controller_config_struct {
+    uint32_t window_ms;                                 // control period
+    uint16_t event_budget[MAX_OD_SUPPORT_TYPES];        // target maximum number of events per window of each type, 0 = not controlled
+    uint8_t min_threshold[MAX_OD_SUPPORT_TYPES];        // operator bounds of each type
+    uint8_t max_threshold[MAX_OD_SUPPORT_TYPES];
+    uint8_t max_step;                                   // maximum change of a threshold per window
+    uint8_t lower_step;                                 // decrease per window while a type stays below half of its budget,
+                                                        // never below the initial threshold
+};
+
+/**
+    @brief: state of the threshold controller
+*/
+struct threshold_controller_struct {
+    struct threshold_controller_config_struct config;
+    uint8_t threshold[MAX_OD_SUPPORT_TYPES];            // threshold values currently set in AI module
+    uint8_t initial_threshold[MAX_OD_SUPPORT_TYPES];    // threshold values set by the application
+    uint16_t events[MAX_OD_SUPPORT_TYPES];              // events of each type in the current window
+    uint16_t confidence_histogram[MAX_OD_SUPPORT_TYPES][THRESHOLD_CONTROLLER_CONF_BINS];  // highest confidence of each event
+    uint32_t window_elapsed_us;
+    uint32_t last_poll_us;
+    uint32_t adjustments;                               // total number of written thresholds
+    FunPtr_ThresholdAdjusted log_func;
+};
+
+/**
+    @brief: fill the recommended settings
+    @parameter:
+        config: give the variable with type "threshold_controller_config_struct" to store the settings
+    @return:
+        (NONE)
+    @remark: one minute window, 30 events per minute and type, thresholds kept between 30 and 90
+*/
+void threshold_controller_default_config(struct threshold_controller_config_struct *config);
+
+/**
+    @brief: initialize the threshold controller
+    @parameter:
+        controller:         the controller to initialize
+        config:             settings of the controller, or NULL to use the recommended settings
+        initial_thresholds: the 21 threshold values given to ai_module_set_od_threshold()
+        now_us:             current time given by interface_micros()
+    @return:
+        (NONE)
+*/
+void threshold_controller_init(struct threshold_controller_struct *controller, const struct threshold_controller_config_struct *config,
+    const uint8_t *initial_thresholds, uint32_t now_us);
+
+/**
+    @brief: register the function logging each threshold adjustment
+    @parameter:
+        controller: the threshold controller
+        log_func:   function with prototype void [Custom_Function_Name](uint8_t type_index, uint8_t old_threshold,
+                    uint8_t new_threshold, uint16_t events, uint16_t budget);
+    @return:
+        (NONE)
+*/
+void threshold_controller_register_log_func(struct threshold_controller_struct *controller, FunPtr_ThresholdAdjusted log_func);
+
+/**
+    @brief: account the OD result of an event
+    @parameter:
+        controller: the threshold controller
+        od_result:  OD result retrieved by ai_module_process_event()
+    @return:
+        (NONE)
+*/
+void threshold_controller_feed(struct threshold_controller_struct *controller, const struct od_data_struct *od_result);
+
+/**
+    @brief: close the control window when it is elapsed and adjust the thresholds of AI module
+    @parameter:
+        controller: the threshold controller
+        now_us:     current time given by interface_micros()
+    @return:
+        number of threshold values written to AI module
+    @remark: call it from the main loop at least once per control window, it accesses AI module only when adjusting
+*/
+uint8_t threshold_controller_poll(struct threshold_controller_struct *controller, uint32_t now_us);
+
+/**
+    @brief: check whether the control window is elapsed, without accessing AI module
+    @parameter:
+        controller: the threshold controller
+        now_us:     current time given by interface_micros()
+    @return:
+        true if threshold_controller_poll() would close the control window
+    @remark: lets the caller skip handing threshold_controller_poll() over to the thread accessing AI module
+*/
+bool threshold_controller_is_due(const struct threshold_controller_struct *controller, uint32_t now_us);
+
+#endif // THRESHOLD_CONTROLLER_H
@@ -0,0 +1,228 @@
+/** InstAI Co. (Public Version)
+    Description: Zone and line-crossing rules evaluated on the OD results through a precomputed zone-membership grid
+    Modified Date: Oct 19, 2026
+*/
+#include "zone_rules.h"
+#include <math.h>
+
+//-- Constant values
+#define TILE_SIZE       (1 << ZONE_RULES_TILE_SHIFT)
+#define TILE_HALF       (TILE_SIZE * 0.5f)
+
+/* ---- internal function prototypes declaration ---- */
+static void fill_polygon(struct zone_rules_struct *rules, const float *px, const float *py, uint8_t point_num, uint8_t zone);
+static uint16_t apply_rules(struct zone_rules_struct *rules, const struct od_object_unit_struct *object, uint32_t zones, uint32_t previous_zones);
+
+void zone_rules_init(struct zone_rules_struct *rules, uint32_t match_distance)
+{
+    memset(rules, 0, sizeof(struct zone_rules_struct));
+    memset(rules->partner, ZONE_RULES_NO_ZONE, sizeof(rules->partner));
+    rules->match_distance = match_distance;
+}
+
+void zone_rules_register_fired_func(struct zone_rules_struct *rules, FunPtr_ZoneRuleFired fired_func)
+{
+    rules->fired_func = fired_func;
+}
+
+static void fill_polygon(struct zone_rules_struct *rules, const float *px, const float *py, uint8_t point_num, uint8_t zone)
+{
+    float crossing[ZONE_RULES_MAX_POINTS];
+    uint32_t zone_bit = 1UL << zone;
+
+    // scanline fill through the tile centers of each grid row
+    for(int row = 0; row < ZONE_RULES_GRID_HEIGHT; row++)
+    {
+        float y = row * TILE_SIZE + TILE_HALF;
+        uint8_t crossing_num = 0;
+        for(uint8_t i = 0, j = point_num - 1; i < point_num; j = i++)
+        {
+            if((py[i] > y) != (py[j] > y))
+            {   // insert the crossing of the edge in order
+                float x = px[i] + (y - py[i]) * (px[j] - px[i]) / (py[j] - py[i]);
+                uint8_t k = crossing_num++;
+                for(; k > 0 && crossing[k - 1] > x; k--)
+                    crossing[k] = crossing[k - 1];
+                crossing[k] = x;
+            }
+        }
+
+        for(uint8_t k = 0; k + 1 < crossing_num; k += 2)
+        {   // tiles whose center lies in [crossing[k], crossing[k + 1])
+            int first = (int)ceilf((crossing[k] - TILE_HALF) / TILE_SIZE);
+            int last = (int)ceilf((crossing[k + 1] - TILE_HALF) / TILE_SIZE) - 1;
+            if(first < 0)
+                first = 0;
+            if(last > ZONE_RULES_GRID_WIDTH - 1)
+                last = ZONE_RULES_GRID_WIDTH - 1;
+            for(int col = first; col <= last; col++)
+                rules->grid[row][col] |= zone_bit;
+        }
+    }
+}
+
+uint8_t zone_rules_add_polygon(struct zone_rules_struct *rules, const struct zone_point_struct *points, uint8_t point_num)
+{
+    float px[ZONE_RULES_MAX_POINTS], py[ZONE_RULES_MAX_POINTS];
+
+    if(point_num < 3 || point_num > ZONE_RULES_MAX_POINTS || rules->zone_num >= ZONE_RULES_MAX_ZONES)
+        return ZONE_RULES_NO_ZONE;
+
+    for(uint8_t i = 0; i < point_num; i++)
+    {
+        px[i] = points[i].x;
+        py[i] = points[i].y;
+    }
+    fill_polygon(rules, px, py, point_num, rules->zone_num);
+    return rules->zone_num++;
+}
+
+uint8_t zone_rules_add_line(struct zone_rules_struct *rules, struct zone_point_struct from, struct zone_point_struct to, uint16_t band)
+{
+    float dx = to.x - from.x, dy = to.y - from.y;
+    float length = sqrtf(dx * dx + dy * dy);
+    if(length == 0 || band == 0 || rules->zone_num + 2 > ZONE_RULES_MAX_ZONES)
+        return ZONE_RULES_NO_ZONE;
+
+    // normal pointing to the left side looking from "from" to "to" (y axis pointing down)
+    float nx = dy / length * band, ny = -dx / length * band;
+    uint8_t left = rules->zone_num, right = rules->zone_num + 1;
+    float px[4] = {(float)from.x, (float)to.x, to.x + nx, from.x + nx};
+    float py[4] = {(float)from.y, (float)to.y, to.y + ny, from.y + ny};
+    fill_polygon(rules, px, py, 4, left);
+    px[2] = to.x - nx;
+    px[3] = from.x - nx;
+    py[2] = to.y - ny;
+    py[3] = from.y - ny;
+    fill_polygon(rules, px, py, 4, right);
+
+    rules->partner[left] = right;
+    rules->partner[right] = left;
+    rules->zone_num += 2;
+    return left;
+}
+
+uint8_t zone_rules_add_rule(struct zone_rules_struct *rules, enum ZONE_RULE_TYPE type, uint8_t zone, uint32_t type_mask)
+{
+    if(zone >= rules->zone_num || rules->rule_num >= ZONE_RULES_MAX_RULES)
+        return ZONE_RULES_NO_ZONE;
+    if(type == ZONE_RULE_CROSS && rules->partner[zone] == ZONE_RULES_NO_ZONE)
+        return ZONE_RULES_NO_ZONE;  // not a side of a line
+
+    struct zone_rule_unit_struct *rule = &rules->rule[rules->rule_num];
+    rule->type = type;
+    rule->zone = zone;
+    rule->type_mask = type_mask;
+    rules->rule_zones |= 1UL << zone;
+    return rules->rule_num++;
+}
+
+uint32_t zone_rules_lookup(const struct zone_rules_struct *rules, uint32_t x, uint32_t y)
+{
+    if(x >= AI_MODULE_FRAME_WIDTH || y >= AI_MODULE_FRAME_HEIGHT)
+        return 0;
+    return rules->grid[y >> ZONE_RULES_TILE_SHIFT][x >> ZONE_RULES_TILE_SHIFT];
+}
+
+static uint16_t apply_rules(struct zone_rules_struct *rules, const struct od_object_unit_struct *object, uint32_t zones, uint32_t previous_zones)
+{
+    uint16_t fired = 0;
+
+    if(((zones | previous_zones) & rules->rule_zones) == 0)
+        return 0;   // the object is not around any zone having rules
+
+    uint32_t type_bit = 0;
+    if(object->object_type >= OD_OBJECT_TYPE_OFFSET && object->object_type < OD_OBJECT_TYPE_OFFSET + MAX_OD_SUPPORT_TYPES)
+        type_bit = 1UL << (object->object_type - OD_OBJECT_TYPE_OFFSET);
+
+    for(uint8_t i = 0; i < rules->rule_num; i++)
+    {
+        const struct zone_rule_unit_struct *rule = &rules->rule[i];
+        if(rule->type_mask != 0 && (rule->type_mask & type_bit) == 0)
+            continue;
+
+        uint32_t zone_bit = 1UL << rule->zone;
+        bool is_fired = false;
+        switch(rule->type)
+        {
+        case ZONE_RULE_PRESENCE:
+            is_fired = (zones & zone_bit) != 0;
+        break;
+        case ZONE_RULE_ENTER:
+            is_fired = (zones & ~previous_zones & zone_bit) != 0;
+        break;
+        case ZONE_RULE_EXIT:
+            is_fired = (previous_zones & ~zones & zone_bit) != 0;
+        break;
+        case ZONE_RULE_CROSS:
+            is_fired = (previous_zones & zone_bit) != 0 && (zones & (1UL << rules->partner[rule->zone])) != 0;
+        break;
+        }
+
+        if(is_fired)
+        {
+            fired++;
+            if(rules->fired_func != NULL)
+                rules->fired_func(i, rule, object);
+        }
+    }
+    return fired;
+}
+
+uint16_t zone_rules_evaluate(struct zone_rules_struct *rules, const struct od_data_struct *od_result)
+{
+    uint16_t fired = 0;
+    uint8_t object_num = od_result->object_num < MAX_OD_SUPPORT_OBJECTS ? od_result->object_num : MAX_OD_SUPPORT_OBJECTS;
+    uint32_t zones[MAX_OD_SUPPORT_OBJECTS];
+    uint64_t max_distance2 = (uint64_t)rules->match_distance * rules->match_distance;
+
+    for(uint8_t j = 0; j < rules->previous_num; j++)
+        rules->previous[j].matched = false;
+
+    for(uint8_t i = 0; i < object_num; i++)
+    {
+        const struct od_object_unit_struct *object = &od_result->object[i];
+        zones[i] = zone_rules_lookup(rules, object->center_x, object->center_y);
+
+        // associate the object with the nearest unmatched object of the same type in the previous OD result
+        uint8_t nearest = ZONE_RULES_NO_ZONE;
+        uint64_t nearest_distance2 = max_distance2;
+        for(uint8_t j = 0; j < rules->previous_num; j++)
+        {
+            const struct zone_rules_object_struct *previous = &rules->previous[j];
+            if(previous->matched || previous->object.object_type != object->object_type)
+                continue;
+            int64_t dx = (int64_t)object->center_x - previous->object.center_x;
+            int64_t dy = (int64_t)object->center_y - previous->object.center_y;
+            uint64_t distance2 = (uint64_t)(dx * dx + dy * dy);
+            if(distance2 <= nearest_distance2)
+            {
+                nearest = j;
+                nearest_distance2 = distance2;
+            }
+        }
+
+        uint32_t previous_zones = 0;
+        if(nearest != ZONE_RULES_NO_ZONE)
+        {
+            rules->previous[nearest].matched = true;
+            previous_zones = rules->previous[nearest].zones;
+        }
+        fired += apply_rules(rules, object, zones[i], previous_zones);
+    }
+
+    // the objects which disappeared left their zones
+    for(uint8_t j = 0; j < rules->previous_num; j++)
+    {
+        if(!rules->previous[j].matched)
+            fired += apply_rules(rules, &rules->previous[j].object, 0, rules->previous[j].zones);
+    }
+
+    for(uint8_t i = 0; i < object_num; i++)
+    {
+        rules->previous[i].object = od_result->object[i];
+        rules->previous[i].zones = zones[i];
+    }
+    rules->previous_num = object_num;
+    return fired;
+}
@@ -0,0 +1,173 @@
+/** InstAI Co. (Public Version)
+    Description: Zone and line-crossing rules evaluated on the OD results through a precomputed zone-membership grid
+    Modified Date: Oct 19, 2026
+    Remark: the zones are rasterized once into a grid of 32-bit zone masks covering the AI module frame,
+        so the zones of a detected object are found with a single lookup whatever the complexity of the polygons,
+        a line is rasterized as two half-plane zones (a band on each side of the segment) and crossing it is
+        detected by associating each object with the nearest object of the same type in the previous OD result
+*/
+
+#ifndef ZONE_RULES_H
+#define ZONE_RULES_H
+
+#include "ai_module.h"
+
+//-- Constant values
+#ifndef ZONE_RULES_TILE_SHIFT
+    // grid tiles are (1 << ZONE_RULES_TILE_SHIFT) pixels wide and high, 0 = one tile per pixel (300 KB grid),
+    // 2 = 4x4 tiles (19 KB grid), 3 = 8x8 tiles (5 KB grid)
+    #define ZONE_RULES_TILE_SHIFT   2
+#endif
+#define ZONE_RULES_GRID_WIDTH   ((AI_MODULE_FRAME_WIDTH + (1 << ZONE_RULES_TILE_SHIFT) - 1) >> ZONE_RULES_TILE_SHIFT)
+#define ZONE_RULES_GRID_HEIGHT  ((AI_MODULE_FRAME_HEIGHT + (1 << ZONE_RULES_TILE_SHIFT) - 1) >> ZONE_RULES_TILE_SHIFT)
+#define ZONE_RULES_MAX_ZONES    32      // one bit of the zone mask per zone
+#define ZONE_RULES_MAX_RULES    64
+#define ZONE_RULES_MAX_POINTS   32      // vertices of a polygon
+#define ZONE_RULES_NO_ZONE      0xFF
+
+//-- Enumerations
+/**
+    @brief: conditions firing a rule
+*/
+enum ZONE_RULE_TYPE
+{
+    ZONE_RULE_PRESENCE = 0,         // an object is in the zone (fired for every OD result)
+    ZONE_RULE_ENTER,                // an object entered the zone (or appeared in it)
+    ZONE_RULE_EXIT,                 // an object left the zone (or disappeared from it)
+    ZONE_RULE_CROSS                 // an object crossed a line from the given side zone to the other side
+};
+
+//-- Structures
+/**
+    @brief: vertex of a zone polygon, in pixels of the AI module frame
+*/
+struct zone_point_struct {
+    int16_t x;
+    int16_t y;
+};
+
+/**
+    @brief: a rule attached to a zone
+*/
+struct zone_rule_unit_struct {
+    enum ZONE_RULE_TYPE type;
+    uint8_t zone;
+    uint32_t type_mask;             // bit (object_type - OD_OBJECT_TYPE_OFFSET) set for each object type concerned, 0 = every type
+};
+
+/**
+    @brief: an object of the previous OD result with its zones
+*/
+struct zone_rules_object_struct {
+    struct od_object_unit_struct object;
+    uint32_t zones;
+    bool matched;
+};
+
+//-- Function Pointer
+/**
+    @brief: function pointer which points to custom function called when a rule fires
+    @parameter:
+        rule_index: index of the rule returned by zone_rules_add_rule()
+        rule:       the rule
+        object:     the object firing the rule (for exits caused by a disappeared object, its last known attributes)
+*/
+typedef void (*FunPtr_ZoneRuleFired)(uint8_t rule_index, const struct zone_rule_unit_struct *rule, const struct od_object_unit_struct *object);
+
+/**
+    @brief: zones, rules and state of the rules engine
+*/
+struct zone_rules_struct {
+    uint32_t grid[ZONE_RULES_GRID_HEIGHT][ZONE_RULES_GRID_WIDTH];   // zone mask of each tile
+    uint8_t zone_num;
+    uint8_t partner[ZONE_RULES_MAX_ZONES];                          // other side of a line zone, ZONE_RULES_NO_ZONE for polygons
+    struct zone_rule_unit_struct rule[ZONE_RULES_MAX_RULES];
+    uint8_t rule_num;
+    uint32_t rule_zones;                                            // zones having at least one rule
+    uint32_t match_distance;                                        // maximum move of an object between two OD results
+    struct zone_rules_object_struct previous[MAX_OD_SUPPORT_OBJECTS];
+    uint8_t previous_num;
+    FunPtr_ZoneRuleFired fired_func;
+};
+
+/**
+    @brief: initialize the rules engine without any zone or rule
+    @parameter:
+        rules:          the rules engine to initialize
+        match_distance: maximum distance in pixels an object moves between two OD results, used to associate
+                        the objects of consecutive OD results (e.g. 40)
+    @return:
+        (NONE)
+*/
+void zone_rules_init(struct zone_rules_struct *rules, uint32_t match_distance);
+
+/**
+    @brief: register the function called when a rule fires
+    @parameter:
+        rules:      the rules engine
+        fired_func: function with prototype void [Custom_Function_Name](uint8_t rule_index, const struct zone_rule_unit_struct *rule,
+                    const struct od_object_unit_struct *object);
+    @return:
+        (NONE)
+*/
+void zone_rules_register_fired_func(struct zone_rules_struct *rules, FunPtr_ZoneRuleFired fired_func);
+
+/**
+    @brief: add a polygon zone
+    @parameter:
+        rules:      the rules engine
+        points:     vertices of the polygon (self-intersecting polygons are filled with the even-odd rule)
+        point_num:  number of vertices, from 3 to ZONE_RULES_MAX_POINTS
+    @return:
+        index of the zone, or ZONE_RULES_NO_ZONE if the polygon is invalid or ZONE_RULES_MAX_ZONES zones are defined
+    @remark: a tile belongs to the zone if its center is inside the polygon
+*/
+uint8_t zone_rules_add_polygon(struct zone_rules_struct *rules, const struct zone_point_struct *points, uint8_t point_num);
+
+/**
+    @brief: add a line, as two zones covering a band on each side of the segment
+    @parameter:
+        rules:  the rules engine
+        from:   first end of the segment
+        to:     second end of the segment
+        band:   width in pixels of each side zone, objects farther from the segment (or beyond its ends) are on neither side
+    @return:
+        index of the zone on the left side of the segment looking from "from" to "to" (the right side zone is the next index),
+        or ZONE_RULES_NO_ZONE if the segment is empty or less than two zones are left
+*/
+uint8_t zone_rules_add_line(struct zone_rules_struct *rules, struct zone_point_struct from, struct zone_point_struct to, uint16_t band);
+
+/**
+    @brief: add a rule
+    @parameter:
+        rules:      the rules engine
+        type:       one of the conditions defined in enumeration ZONE_RULE_TYPE
+        zone:       index of the zone, for ZONE_RULE_CROSS the side zone of a line the objects come from
+        type_mask:  bit (object_type - OD_OBJECT_TYPE_OFFSET) set for each object type concerned, 0 = every type
+    @return:
+        index of the rule, or ZONE_RULES_NO_ZONE if the zone is invalid or ZONE_RULES_MAX_RULES rules are defined
+*/
+uint8_t zone_rules_add_rule(struct zone_rules_struct *rules, enum ZONE_RULE_TYPE type, uint8_t zone, uint32_t type_mask);
+
+/**
+    @brief: get the zones containing a point
+    @parameter:
+        rules:  the rules engine
+        x, y:   coordinates in pixels of the AI module frame
+    @return:
+        bit mask of the zones containing the point
+*/
+uint32_t zone_rules_lookup(const struct zone_rules_struct *rules, uint32_t x, uint32_t y);
+
+/**
+    @brief: evaluate the rules on the OD result of an event and call the registered function for each rule fired
+    @parameter:
+        rules:      the rules engine
+        od_result:  OD result retrieved by ai_module_process_event()
+    @return:
+        number of rules fired
+    @remark: the cost per object is one grid lookup and a pass over the rules of its zones, independent of the polygons
+*/
+uint16_t zone_rules_evaluate(struct zone_rules_struct *rules, const struct od_data_struct *od_result);
+
+#endif // ZONE_RULES_H